@@ -9,6 +9,7 @@
 #define ENTITY_HPP_
 
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 
 namespace client
@@ -16,18 +17,25 @@ namespace client
 
 class Registry;
 
+// Handle to an entity: its id plus the generation of that id when it was spawned.
+// The server recycles ids, the generation tells a stale handle from the entity now using the same id.
 class Entity
 {
   public:
-    explicit Entity(size_t id = std::numeric_limits<size_t>::max()) : _id(id) {}
+    explicit Entity(size_t id = std::numeric_limits<size_t>::max(), uint32_t generation = 0)
+        : _id(id), _generation(generation)
+    {}
 
     // Implicit conversion to size_t for component array indexing
     operator size_t() const { return _id; }
 
     bool isValid() const { return _id != std::numeric_limits<size_t>::max(); }
 
+    uint32_t generation() const { return _generation; }
+
   private:
     size_t _id;
+    uint32_t _generation;
 
     // Allow registry to create and manage entities
     friend class Registry;
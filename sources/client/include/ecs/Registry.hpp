@@ -16,9 +16,11 @@
 #include <any>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <typeindex>
 #include <unordered_map>
+#include <vector>
 
 namespace client
 {
@@ -117,22 +119,24 @@ class Registry
      * Create a new entity
      * 
      * @param id the ID of the entity
-     * @details Find if the entity ID already exists in the entities list
-     * If it does, throw an exception
-     * Create a new entity with the specified ID and add it to the entities list
-     * @return the new entity
+     * @details The ID is chosen by the server, if it is already in use throw an exception
+     * Add the entity to the entities list and remember where, so it can be removed in O(1)
+     * @return the new entity, with the current generation of the ID
      */
     Entity spawn_entity(size_t id)
     {
-        Entity entity(id);
-
-        auto check_entity = find_entity(entity);
-
-        if (check_entity)
+        if (find_entity(Entity(id)))
         {
             throw std::runtime_error("Error: Entity ID already exists!");
         }
 
+        if (id >= _entity_slots.size())
+        {
+            _entity_slots.resize(id + 1, {0, NOT_LIVE});
+        }
+
+        Entity entity(id, _entity_slots[id].generation);
+        _entity_slots[id].live = _entities.size();
         _entities.push_back(entity);
 
         // std::cout << "Spawned entity with ID: " << id << std::endl;
@@ -143,31 +147,37 @@ class Registry
     /**
      * Remove an entity
      * 
-     * @param entity the entity to remove
+     * @param entity the entity to remove, only its ID is used as the server refers to entities by ID
      * @details Remove components for this entity
-     * Remove the entity from the active list
-     * Recycle the entity ID
+     * Swap the last active entity into its place in the active list
+     * Bump the generation of the ID so the handles kept on it become stale
      */
     void kill_entity(const Entity &entity)
     {
-        for (auto &remover : _component_removers)
+        if (!find_entity(entity))
         {
-            remover.second(entity);
+            return;
         }
 
-        auto it = std::find(_entities.begin(), _entities.end(), entity);
-        if (it != _entities.end())
+        for (auto &remover : _component_removers)
         {
-            _entities.erase(it);
+            remover.second(entity);
         }
 
-        _reusable_entity.push_back(entity);
+        EntitySlot &slot = _entity_slots[entity._id];
+        Entity last = _entities.back();
+        _entities[slot.live] = last;
+        _entity_slots[last._id].live = slot.live;
+        _entities.pop_back();
+
+        slot.live = NOT_LIVE;
+        ++slot.generation;
     }
 
     /**
      * Get the active entities
      * 
-     * @return the list of active entities
+     * @return the list of active entities, in no particular order
      */
     const std::vector<Entity> &get_active_entities() const { return _entities; }
 
@@ -272,10 +282,41 @@ class Registry
         }
     }
 
-    bool find_entity(const Entity &entity)
+    /**
+     * Check if an entity with this ID is active
+     * 
+     * @param entity the entity to look for, only its ID is used
+     * @return true if an entity is spawned with this ID
+     */
+    bool find_entity(const Entity &entity) const
     {
-        auto it = std::find(_entities.begin(), _entities.end(), entity);
-        return it != _entities.end();
+        return entity._id < _entity_slots.size() && _entity_slots[entity._id].live != NOT_LIVE;
+    }
+
+    /**
+     * Get the handle of the active entity with this ID
+     * 
+     * @param id the ID of the entity
+     * @return the handle with the current generation of the ID, an invalid entity if none is active
+     */
+    Entity get_entity(size_t id) const
+    {
+        if (!find_entity(Entity(id)))
+        {
+            return Entity();
+        }
+        return Entity(id, _entity_slots[id].generation);
+    }
+
+    /**
+     * Check if a handle still refers to a live entity
+     * 
+     * @param entity the handle, as returned by spawn_entity
+     * @return false once the entity was killed, even if its ID was spawned again since
+     */
+    bool is_alive(const Entity &entity) const
+    {
+        return find_entity(entity) && _entity_slots[entity._id].generation == entity._generation;
     }
 
     friend std::ostream &operator<<(std::ostream &os, const Registry &registry);
@@ -309,9 +350,16 @@ class Registry
     std::vector<std::function<void()>> _systems;
 
     // Entity management
+    static constexpr size_t NOT_LIVE = std::numeric_limits<size_t>::max();
+
+    struct EntitySlot
+    {
+        uint32_t generation;  // Bumped each time the ID is killed
+        size_t live;          // Index in _entities, NOT_LIVE while the ID is free
+    };
+
     std::vector<Entity> _entities;
-    std::vector<size_t> _reusable_entity;
-    size_t _next_entity = 0;
+    std::vector<EntitySlot> _entity_slots;  // ID -> slot
     std::vector<ParallaxLayer> _parallaxLayers;
     sf::RectangleShape _healthBarBox;
     sf::RectangleShape _healthBar;
@@ -323,7 +371,7 @@ class Registry
  * 
  * @param os the output stream
  * @param registry the registry to output
- * @details Output the current state of the registry, including live and reusable entity IDs
+ * @details Output the current state of the registry, the live entity IDs
  * @return the output stream
  */
 inline std::ostream &operator<<(std::ostream &os, const Registry &registry)
@@ -339,17 +387,6 @@ inline std::ostream &operator<<(std::ostream &os, const Registry &registry)
             os << ", ";
         }
     }
-    os << "]" << std::endl;
-
-    os << " - Reusable entities id (size_t): [";
-    for (const auto &dead_entity : registry._reusable_entity)
-    {
-        os << dead_entity;
-        if (dead_entity != registry._reusable_entity.back())
-        {
-            os << ", ";
-        }
-    }
     os << "]";
 
     return os;
@@ -17,6 +17,8 @@
 #include "ecs/components/type.hpp"
 #include "ecs/components/update.hpp"
 #include "ecs/components/velocity.hpp"
+#include "network/InputPredictor.hpp"
+#include "network/SnapshotInterpolator.hpp"
 
 #include <SFML/Graphics.hpp>
 #include <memory>
@@ -28,6 +30,8 @@ void render_system(Registry &registry, sf::RenderWindow &window);
 void movement_system(client::Registry &registry, float &deltaTime);
 void collision_system(client::Registry &registry);
 void life_system(client::Registry &registry, Entity clientEntity);
+void interpolation_system(client::Registry &registry, SnapshotInterpolator &interpolator, Entity &clientEntity);
+void prediction_system(client::Registry &registry, InputPredictor &predictor, Entity &clientEntity);
 void animation_system(client::Registry &registry, float deltaTime);
 void animation_event_system(client::Registry &registry, float deltaTime);
 
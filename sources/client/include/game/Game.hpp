@@ -14,7 +14,9 @@
 #include "ecs/components/health.hpp"
 #include "game/ParallaxLayer.hpp"
 #include "game/animation/AnimationManager.hpp"
+#include "network/InputPredictor.hpp"
 #include "network/NetworkManager.hpp"
+#include "network/SnapshotInterpolator.hpp"
 
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
@@ -46,6 +48,8 @@ class Game
     float _deltaTime;
     sf::Clock _clock;
     NetworkManager _networkManager;
+    SnapshotInterpolator _interpolator;
+    InputPredictor _predictor;
     AnimationManager _animationManager;
     Entity _playerEntity;
     Menu _menu;
@@ -64,7 +68,12 @@ class Game
     float _timeSinceLastShot;
     const float _shotCooldown = 0.5f;
 
-    uint8_t _processInput(sf::Event event);
+    // input sampling
+    float _inputTimer = 0.0f;                     // time since the last input tick
+    unsigned int _idleInputs = INPUT_REDUNDANCY;  // empty commands sent since the keys were released
+
+    uint8_t _sampleInput();
+    void _sendInput();
 
     void _createEntity(const EntityState &entityState);
     void _createPlayer(Entity entity, components::position pos, components::velocity vel, components::health health);
@@ -82,7 +91,6 @@ class Game
     void _addSystems();
     void _applyStateUpdate(const StateUpdateMessage &stateMsg);
     void _applyGameOver(const GameOverMessage &gameOverMsg);
-    void _applyLocalMovement(uint8_t inputFlags);
 
     // state update methods
     void _handleEvents();
@@ -0,0 +1,64 @@
+/*
+** EPITECH PROJECT, 2025
+** R-Type
+** File description:
+** BitStream
+*/
+
+#ifndef BITSTREAM_HPP_
+#define BITSTREAM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace client
+{
+
+/**
+ * @brief Appends values of any width (up to 32 bits) to a byte buffer, least significant bit first.
+ *
+ * Same encoding as the server BitWriter. flush() pads the last byte with zeros and must be called after the last
+ * write.
+ */
+class BitWriter
+{
+  public:
+    BitWriter(std::vector<uint8_t> &buffer);
+    ~BitWriter();
+
+    void write(uint32_t value, unsigned int bits);
+    void writeVarint(uint32_t value);
+    void flush();
+
+  private:
+    std::vector<uint8_t> &_buffer;
+    uint64_t _scratch;    // bits not written to the buffer yet
+    unsigned int _count;  // number of bits in _scratch
+};
+
+/**
+ * @brief Reads back what a BitWriter wrote, throws std::runtime_error past the end of the buffer.
+ */
+class BitReader
+{
+  public:
+    BitReader(std::span<const uint8_t> buffer, size_t offset);
+    ~BitReader();
+
+    uint32_t read(unsigned int bits);
+    uint32_t readVarint();
+
+  private:
+    std::span<const uint8_t> _buffer;
+    size_t _offset;       // next byte to load
+    uint64_t _scratch;    // bits loaded but not read yet
+    unsigned int _count;  // number of bits in _scratch
+};
+
+unsigned int varintBits(uint32_t value);
+
+}  // namespace client
+
+#endif /* !BITSTREAM_HPP_ */
@@ -0,0 +1,51 @@
+/*
+** EPITECH PROJECT, 2025
+** R-Type
+** File description:
+** FragmentAssembler
+*/
+
+#ifndef FRAGMENTASSEMBLER_HPP_
+#define FRAGMENTASSEMBLER_HPP_
+
+#include "network/Protocol.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Number of fragmented messages that can be put back together at the same time
+#define FRAGMENT_ASSEMBLY_SLOTS 8
+
+namespace client
+{
+
+/**
+ * @brief Puts back together the messages the server split into FragmentMessages.
+ *
+ * Fragments may arrive in any order. A message missing a fragment is never completed: its slot is taken over by a
+ * newer group, the snapshot after it will be a delta against the last one we acked.
+ */
+class FragmentAssembler
+{
+  public:
+    FragmentAssembler();
+    ~FragmentAssembler();
+
+    bool add(const FragmentView &fragment, std::vector<uint8_t> &message);
+
+  private:
+    struct Assembly
+    {
+        uint32_t groupId = 0;
+        uint8_t fragmentCount = 0;                   // 0 once the message was completed
+        uint8_t received = 0;
+        std::vector<std::vector<uint8_t>> payloads;  // empty until the fragment is received
+    };
+
+    std::array<Assembly, FRAGMENT_ASSEMBLY_SLOTS> _assemblies;
+};
+
+}  // namespace client
+
+#endif /* !FRAGMENTASSEMBLER_HPP_ */
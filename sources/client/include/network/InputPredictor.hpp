@@ -0,0 +1,67 @@
+/*
+** EPITECH PROJECT, 2025
+** R-Type
+** File description:
+** InputPredictor
+*/
+
+#ifndef INPUTPREDICTOR_HPP_
+#define INPUTPREDICTOR_HPP_
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// Distance the server moves a player per input command, vertically (twice that horizontally), same as the server
+#define PREDICTION_STEP 10.0f
+// The server keeps the players in the world: x is clamped to [0, width - player width], y wraps around [0, height]
+#define PREDICTION_WORLD_WIDTH 1920.0f
+#define PREDICTION_WORLD_HEIGHT 1080.0f
+#define PREDICTION_PLAYER_WIDTH 175.0f
+// Commands kept until the server acks them, the oldest ones are dropped past that
+#define PREDICTION_MAX_PENDING 128
+
+namespace client
+{
+
+/**
+ * @brief Moves our player as soon as an input command is sent, without waiting for the server.
+ *
+ * The commands are applied with the server's movement rules and kept until the server acks them. An ack gives the
+ * player's position once the server applied that command: the prediction restarts from it and the commands the
+ * server didn't apply yet are replayed on top.
+ * Commands are pushed by the game thread, acks come from the network thread.
+ */
+class InputPredictor
+{
+  public:
+    InputPredictor();
+    ~InputPredictor();
+
+    void reset(float posX, float posY);
+    void push(uint32_t sequence, uint8_t inputFlags);
+    void acknowledge(uint32_t sequence, float posX, float posY);
+    void correct(float posX, float posY);
+
+    bool position(float &posX, float &posY) const;
+
+    static void applyInput(float &posX, float &posY, uint8_t inputFlags);
+
+  private:
+    struct Command
+    {
+        uint32_t sequence;
+        uint8_t inputFlags;
+    };
+
+    mutable std::mutex _mutex;
+    std::deque<Command> _pending;  // sent and not acked yet, by sequence
+    uint32_t _acked = 0;           // last command acked
+    float _posX = 0.0f;            // predicted position
+    float _posY = 0.0f;
+    bool _valid = false;           // set once reset
+};
+
+}  // namespace client
+
+#endif /* !INPUTPREDICTOR_HPP_ */
@@ -8,21 +8,35 @@
 #ifndef NETWORKMANAGER_HPP
 #define NETWORKMANAGER_HPP
 
+#include "network/FragmentAssembler.hpp"
 #include "network/Protocol.hpp"
+#include "network/ReliableChannel.hpp"
+#include "network/SnapshotHistory.hpp"
 #include "utils/dotenv.h"
 
+#include <array>
 #include <asio.hpp>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <random>
+#include <span>
 #include <thread>
 #include <unordered_map>
 
 #define MAX_UPDATES_PER_CYCLE 5
 
-#define MAX_MESSAGE_SIZE 2308
+// Bigger messages are sent as FragmentMessages
+#define MAX_MESSAGE_SIZE MAX_DATAGRAM_SIZE
+
+// How long disconnecting waits for the server to ack the DisconnectMessage
+#define DISCONNECT_ACK_TIMEOUT_MS 500
+
+// Input commands sent per second by default, the keys held are sampled at that rate
+#define INPUT_SEND_RATE 30
 
 namespace client
 {
@@ -32,6 +46,7 @@ class NetworkManager
   public:
     using StateUpdateCallback = std::function<void(const StateUpdateMessage &)>;
     using GameOverCallback = std::function<void(const GameOverMessage &)>;
+    using InputAckCallback = std::function<void(const InputAckMessage &)>;
 
     NetworkManager(float &deltaTime);
     ~NetworkManager();
@@ -39,11 +54,14 @@ class NetworkManager
     // Public methods
     void connectToServer();
     void disconnectFromServer();
-    void sendUserInput(uint8_t inputFlags);
+    uint32_t sendUserInput(uint8_t inputFlags);
+    void setInputRate(unsigned int rate);
+    unsigned int getInputRate() const;
     void startReceive();
     void run();
     void setStateUpdateCallback(StateUpdateCallback callback);
     void setGameOverCallback(GameOverCallback callback);
+    void setInputAckCallback(InputAckCallback callback);
 
     // New public methods for update queue
     bool hasPendingUpdates() const;
@@ -58,8 +76,15 @@ class NetworkManager
   private:
     // Private utility methods
     void _handleReceive(const asio::error_code &error, std::size_t bytes_transferred);
-    void _processReceivedMessage(const std::vector<uint8_t> &data);
+    void _processReceivedMessage(std::span<const uint8_t> data);
     void _handleStateUpdate(const StateUpdateMessage &stateMsg);
+    void _handleDeltaStateUpdate(const DeltaStateUpdateMessage &deltaMsg);
+    void _sendSnapshotAck(uint32_t sequence);
+    void _sendControl(std::vector<uint8_t> message);
+    void _flushControl();
+    void _startControlTimer();
+    void _sendReliable(const ReliableMessage &reliableMsg);
+    void _handleReliable(const ReliableView &reliableMsg);
     uint32_t _generateClientId();
     void _processStateUpdate(const StateUpdateMessage &stateMsg);
 
@@ -68,14 +93,34 @@ class NetworkManager
     asio::ip::udp::socket _clientSocket;
     asio::ip::udp::endpoint _serverEndpoint;
     std::vector<uint8_t> _recv_buffer;
+    asio::steady_timer _controlTimer;  // resends the control messages the server didn't ack
 
     // State variables
     uint32_t _clientId;
     std::atomic<bool> _isConnected;
     std::thread _receiveThread;
 
+    // Delta snapshots
+    SnapshotHistory _snapshots;
+    uint32_t _lastSequence = 0;           // last snapshot handed to the game
+    std::vector<uint32_t> _liveEntities;  // sorted ids of the entities in that snapshot
+    StateUpdateMessage _stateMsg;         // reused to hand the rebuilt snapshots to the game
+    DeltaStateUpdateMessage _deltaMsg;    // reused to decode the deltas, its lists keep their capacity
+    FragmentAssembler _fragments;         // snapshots bigger than a datagram
+
+    // Control messages, only touched on the network thread but _controlIdle
+    ReliableChannel _control;
+    std::atomic<bool> _controlIdle = true;  // every control message was acked
+    std::vector<uint8_t> _assembled;        // reused to put the fragmented snapshots back together
+
+    // Input commands, only touched by the game thread
+    uint32_t _inputSequence = 0;                               // last command sent
+    std::array<uint8_t, INPUT_REDUNDANCY> _previousInputs {};  // flags of the last commands sent, newest first
+    unsigned int _inputRate = INPUT_SEND_RATE;                 // commands per second
+
     StateUpdateCallback _stateUpdateCallback;
     GameOverCallback _gameOverCallback;
+    InputAckCallback _inputAckCallback;
 
     // New variables for update queue
     mutable std::mutex _queueMutex;
@@ -0,0 +1,121 @@
+/*
+** EPITECH PROJECT, 2025
+** R-Type
+** File description:
+** ReliableChannel
+*/
+
+#ifndef RELIABLECHANNEL_HPP_
+#define RELIABLECHANNEL_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+// Interval at which a control message is sent again until it is acked, same as the server
+#define RELIABLE_RESEND_MS 100
+// Messages received ahead of the next one to handle, the ones further ahead are dropped (and resent later)
+#define RELIABLE_WINDOW 32
+
+namespace client
+{
+
+/**
+ * @brief Our end of the reliable ordered channel the control messages travel on (see ReliableMessage).
+ *
+ * It doesn't send anything itself: sent messages are kept until the server acks them and handed back by resend()
+ * every RELIABLE_RESEND_MS. Received messages are handed out once each, in sequence order.
+ * Not thread safe, only used on the network thread.
+ */
+class ReliableChannel
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    ReliableChannel();
+    ~ReliableChannel();
+
+    uint32_t push(std::span<const uint8_t> message);
+    void acknowledge(uint32_t ack, uint32_t ackBits);
+    bool idle() const;
+
+    /**
+     * @brief Calls send(sequence, message) for the messages never sent or not acked RELIABLE_RESEND_MS after their
+     * last send.
+     */
+    template <typename Send> void resend(Clock::time_point now, Send send)
+    {
+        for (Pending &pending : _pending)
+        {
+            if (pending.sentAt != Clock::time_point() &&
+                now - pending.sentAt < std::chrono::milliseconds(RELIABLE_RESEND_MS))
+                continue;
+            pending.sentAt = now;
+            send(pending.sequence, std::span<const uint8_t>(pending.message));
+        }
+    }
+
+    /**
+     * @brief Takes a message received from the server.
+     *
+     * @param deliver: called with each message this one made ready, in order, before this returns
+     * @return true if the message must be acked (it is new or a duplicate)
+     */
+    template <typename Deliver> bool receive(uint32_t sequence, std::span<const uint8_t> message, Deliver deliver)
+    {
+        if (sequence == 0 || sequence >= _nextDelivery + RELIABLE_WINDOW)
+            return false;
+        if (sequence < _nextDelivery)
+            return true;
+
+        Early &early = _early[sequence % RELIABLE_WINDOW];
+        if (!early.received)
+        {
+            early.received = true;
+            early.message.assign(message.begin(), message.end());
+            _lastReceived = std::max(_lastReceived, sequence);
+        }
+        while (_early[_nextDelivery % RELIABLE_WINDOW].received)
+        {
+            Early &next = _early[_nextDelivery++ % RELIABLE_WINDOW];
+
+            next.received = false;
+            deliver(std::span<const uint8_t>(next.message));
+        }
+        return true;
+    }
+
+    uint32_t lastReceived() const;
+    uint32_t ackBits(uint32_t ack) const;
+
+  private:
+    struct Pending
+    {
+        uint32_t sequence;
+        std::vector<uint8_t> message;
+        Clock::time_point sentAt;  // epoch until it is sent
+    };
+
+    struct Early
+    {
+        bool received = false;
+        std::vector<uint8_t> message;
+    };
+
+    bool _received(uint32_t sequence) const;
+
+    uint32_t _nextSequence = 1;
+    std::deque<Pending> _pending;  // by sequence
+
+    uint32_t _nextDelivery = 1;
+    uint32_t _lastReceived = 0;
+    std::array<Early, RELIABLE_WINDOW> _early;  // sequences [_nextDelivery, _nextDelivery + RELIABLE_WINDOW)
+};
+
+}  // namespace client
+
+#endif /* !RELIABLECHANNEL_HPP_ */
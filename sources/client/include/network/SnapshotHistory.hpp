@@ -0,0 +1,50 @@
+/*
+** EPITECH PROJECT, 2025
+** R-Type
+** File description:
+** SnapshotHistory
+*/
+
+#ifndef SNAPSHOTHISTORY_HPP_
+#define SNAPSHOTHISTORY_HPP_
+
+#include "network/Protocol.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Number of rebuilt snapshots kept as delta baselines, same as the server
+#define SNAPSHOT_HISTORY_SIZE 32
+
+namespace client
+{
+
+/**
+ * @brief Ring of the last snapshots rebuilt from the server deltas, entities sorted by id.
+ *
+ * The server sends each snapshot relative to the last one we acked, which is always still in the ring.
+ */
+class SnapshotHistory
+{
+  public:
+    SnapshotHistory();
+    ~SnapshotHistory();
+
+    const std::vector<EntityState> *apply(const DeltaStateUpdateMessage &delta);
+    const std::vector<EntityState> *find(uint32_t sequence) const;
+
+  private:
+    struct Snapshot
+    {
+        uint32_t sequence = 0;
+        std::vector<EntityState> entities;
+    };
+
+    std::array<Snapshot, SNAPSHOT_HISTORY_SIZE> _snapshots;
+    std::vector<EntityState> _scratch;
+};
+
+}  // namespace client
+
+#endif /* !SNAPSHOTHISTORY_HPP_ */
@@ -0,0 +1,76 @@
+/*
+** EPITECH PROJECT, 2025
+** R-Type
+** File description:
+** SnapshotInterpolator
+*/
+
+#ifndef SNAPSHOTINTERPOLATOR_HPP_
+#define SNAPSHOTINTERPOLATOR_HPP_
+
+#include "network/Protocol.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Snapshots kept to interpolate between, about half a second at 60 snapshots per second
+#define INTERPOLATION_SNAPSHOTS 32
+// How far behind the last snapshot the entities are shown by default
+#define INTERPOLATION_DELAY_MS 100
+// Once past the last snapshot, entities keep moving on their velocity for this long at most
+#define MAX_EXTRAPOLATION_MS 250
+// An entity moving more than this between two snapshots wrapped around the world or was replaced: it is not blended
+#define INTERPOLATION_SNAP_DISTANCE 400.0f
+
+namespace client
+{
+
+/**
+ * @brief Timestamped buffer of the last snapshots, to show the entities a little in the past.
+ *
+ * The entities are rendered at now - delay, between the two snapshots around that time, so their movement stays
+ * smooth when snapshots arrive late, bunched up or not at all for a few ticks. Past the newest snapshot they are
+ * extrapolated on their velocity, for MAX_EXTRAPOLATION_MS at most.
+ * Snapshots are pushed by the network thread and sampled by the game thread.
+ */
+class SnapshotInterpolator
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    SnapshotInterpolator(std::chrono::milliseconds delay = std::chrono::milliseconds(INTERPOLATION_DELAY_MS));
+    ~SnapshotInterpolator();
+
+    void setDelay(std::chrono::milliseconds delay);
+    std::chrono::milliseconds getDelay() const;
+
+    void push(const std::vector<EntityState> &entities, Clock::time_point received = Clock::now());
+    void clear();
+
+    const std::vector<EntityState> &sample(Clock::time_point now);
+
+  private:
+    struct Snapshot
+    {
+        Clock::time_point received;
+        Clock::time_point time;             // when it is shown, received spread out at the average interval
+        std::vector<EntityState> entities;  // sorted by id
+    };
+
+    const Snapshot &_at(size_t index) const;  // 0 is the oldest
+
+    mutable std::mutex _mutex;
+    std::chrono::milliseconds _delay;
+    std::array<Snapshot, INTERPOLATION_SNAPSHOTS> _snapshots;
+    size_t _first = 0;
+    size_t _count = 0;
+    Clock::duration _interval = Clock::duration::zero();  // average time between two snapshots
+    std::vector<EntityState> _sampled;                     // only touched by the game thread
+};
+
+}  // namespace client
+
+#endif /* !SNAPSHOTINTERPOLATOR_HPP_ */
@@ -85,6 +85,47 @@ void client::movement_system(client::Registry &registry, float &deltaTime)
     // std::cout << "Movement time: " << clock.getElapsedTime().asMilliseconds() << "ms" << std::endl;
 }
 
+/**
+ * @brief Moves the entities other than ours to where they were at the interpolator's render time.
+ *
+ * Runs after movement_system, the positions it extrapolated from the velocities are overwritten.
+ */
+void client::interpolation_system(client::Registry &registry, SnapshotInterpolator &interpolator, Entity &clientEntity)
+{
+    auto &positions = registry.get_components<components::position>();
+    auto &types = registry.get_components<components::type>();
+
+    for (const EntityState &state : interpolator.sample(SnapshotInterpolator::Clock::now()))
+    {
+        std::size_t entity = state.entityId;
+
+        // Our player is moved locally, a type mismatch means the id was given to another entity since
+        if (entity == clientEntity || entity >= positions.size() || !positions[entity] || !types[entity] ||
+            types[entity]->type != state.entityType)
+            continue;
+        positions[entity]->x = state.posX;
+        positions[entity]->y = state.posY;
+    }
+}
+
+/**
+ * @brief Moves our player to its predicted position, the commands the server didn't ack yet applied.
+ */
+void client::prediction_system(client::Registry &registry, InputPredictor &predictor, Entity &clientEntity)
+{
+    auto &positions = registry.get_components<components::position>();
+    std::size_t entity = clientEntity;
+    float posX = 0.0f;
+    float posY = 0.0f;
+
+    // Dead, its id may already belong to another entity
+    if (!registry.is_alive(clientEntity) || entity >= positions.size() || !positions[entity] ||
+        !predictor.position(posX, posY))
+        return;
+    positions[entity]->x = posX;
+    positions[entity]->y = posY;
+}
+
 void client::collision_system(client::Registry &registry)
 {
     sf::Clock clock;
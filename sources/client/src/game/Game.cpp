@@ -9,6 +9,8 @@
 
 #include "utils/entity_type.hpp"
 
+#include <cmath>
+
 using namespace client;
 
 /**
@@ -107,32 +109,21 @@ void Game::_networkConnection()
         [this](const StateUpdateMessage &stateMsg) { this->_applyStateUpdate(stateMsg); });
     _networkManager.setGameOverCallback(
         [this](const GameOverMessage &gameOverMsg) { this->_applyGameOver(gameOverMsg); });
+    _networkManager.setInputAckCallback([this](const InputAckMessage &ackMsg) {
+        this->_predictor.acknowledge(ackMsg.sequence, ackMsg.posX, ackMsg.posY);
+    });
+    _interpolator.clear();
 
     // _networkManager.connectToServer();
 }
 
 /**
- * @brief Handles all window events, such as user inputs and window closing.
+ * @brief Handles all window events, such as window closing. The keys held are sampled by _sendInput.
  */
 void Game::_handleEvents()
 {
     while (_window.pollEvent(_event))
     {
-        if (_event.type == sf::Event::KeyPressed)
-        {
-            uint8_t input = _processInput(_event);
-
-            if (input != NONE)
-            {
-                _networkManager.sendUserInput(input);
-
-                if (_playerEntity != -1 && input != static_cast<uint8_t>(InputFlags::Fire))
-                {
-                    _applyLocalMovement(input);
-                }
-            }
-        }
-
         if (_event.type == sf::Event::Closed)
         {
             _window.close();
@@ -152,6 +143,7 @@ void Game::_update()
     // std::cout << "Updating game..." << std::endl;
     _deltaTime = _clock.restart().asSeconds();
     _timeSinceLastShot += _deltaTime;
+    _sendInput();
 
     sf::Clock clock;
     clock.restart();
@@ -168,29 +160,6 @@ void Game::_update()
     std::cout << "Time to run systems: " << clock.getElapsedTime().asMilliseconds() << std::endl;
 }
 
-/**
- * Applies local movement based on user input.
- *
- * @param inputFlags: Flags representing the user's input.
- */
-void Game::_applyLocalMovement(uint8_t inputFlags)
-{
-    const float speed = 180.0f;
-
-    components::velocity velocity {0.0f, 0.0f};
-
-    if (inputFlags == static_cast<uint8_t>(InputFlags::MoveUp))
-        velocity.y = -speed;
-    else if (inputFlags == static_cast<uint8_t>(InputFlags::MoveDown))
-        velocity.y = speed;
-    else if (inputFlags == static_cast<uint8_t>(InputFlags::MoveLeft))
-        velocity.x = -speed;
-    else if (inputFlags == static_cast<uint8_t>(InputFlags::MoveRight))
-        velocity.x = speed;
-
-    _updateComponents<components::velocity>(_playerEntity, velocity);
-}
-
 /**
  * Applies state updates received from the server.
  *
@@ -198,6 +167,14 @@ void Game::_applyLocalMovement(uint8_t inputFlags)
  */
 void Game::_applyStateUpdate(const StateUpdateMessage &stateMsg)
 {
+    for (uint32_t entityId : stateMsg.destroyedEntities)
+    {
+        Entity entity(static_cast<size_t>(entityId));
+
+        if (_registry.find_entity(entity))
+            _registry.kill_entity(entity);
+    }
+
     for (const auto &entityState : stateMsg.entities)
     {
         Entity entity(static_cast<size_t>(entityState.entityId));
@@ -211,6 +188,9 @@ void Game::_applyStateUpdate(const StateUpdateMessage &stateMsg)
         }
     }
 
+    // The other entities are moved by interpolation_system, from the snapshots around the render time
+    _interpolator.push(stateMsg.entities);
+
     _updateTimer = 0.0f;
     _firstUpdate = false;
 }
@@ -234,29 +214,65 @@ void Game::_applyGameOver(const GameOverMessage &gameOverMsg)
 }
 
 /**
- * Processes the input event and returns the corresponding command
+ * Samples the keys held, once per input tick.
  *
- * @param event: the input event
- * @return the command corresponding to the input event
+ * @return the InputFlags of the keys held, without Fire while the shot cooldown runs
  */
-uint8_t Game::_processInput(sf::Event event)
+uint8_t Game::_sampleInput()
 {
-    if (_commands.find(event.key.code) != _commands.end())
+    uint8_t input = 0;
+
+    if (!_window.hasFocus())
+        return input;
+
+    for (const auto &[key, flag] : _commands)
+    {
+        if (sf::Keyboard::isKeyPressed(key))
+            input |= static_cast<uint8_t>(flag);
+    }
+
+    if (input & static_cast<uint8_t>(InputFlags::Fire))
     {
-        if (event.key.code == sf::Keyboard::Space)
+        if (_timeSinceLastShot >= _shotCooldown)
         {
-            if (_timeSinceLastShot >= _shotCooldown)
-            {
-                _timeSinceLastShot = 0.0f;
-                _shotSound.play();
-                return static_cast<uint8_t>(_commands[event.key.code]);
-            }
+            _timeSinceLastShot = 0.0f;
+            _shotSound.play();
         } else
         {
-            return static_cast<uint8_t>(_commands[event.key.code]);
+            input &= ~static_cast<uint8_t>(InputFlags::Fire);
         }
     }
-    return NONE;  // No hay input válido
+    return input;
+}
+
+/**
+ * Sends the keys held as one input command per input tick, at the network manager's input rate.
+ *
+ * The rate doesn't depend on the frame rate nor on the OS key repeat. Once the keys are released, INPUT_REDUNDANCY
+ * empty commands still go out so the last ones are repeated, then nothing is sent until a key is held again.
+ */
+void Game::_sendInput()
+{
+    float interval = 1.0f / static_cast<float>(_networkManager.getInputRate());
+
+    _inputTimer += _deltaTime;
+    if (_inputTimer < interval)
+        return;
+    // The ticks missed during a long frame are skipped, not sent at once
+    _inputTimer = std::fmod(_inputTimer, interval);
+
+    uint8_t input = _sampleInput();
+    if (input == 0 && _idleInputs >= INPUT_REDUNDANCY)
+        return;
+    _idleInputs = (input == 0) ? _idleInputs + 1 : 0;
+
+    uint32_t sequence = _networkManager.sendUserInput(input);
+
+    // Moved right away, the server's ack of the command corrects it if needed
+    if (sequence != 0 && _registry.is_alive(_playerEntity))
+    {
+        _predictor.push(sequence, input);
+    }
 }
 
 /**
@@ -278,7 +294,11 @@ void Game::_updateEntity(Entity entity, const EntityState &entityState)
     components::position pos {entityState.posX, entityState.posY};
     components::velocity vel {entityState.velX, entityState.velY};
 
-    _updateComponents<components::position>(entity, pos);
+    // Ours is predicted, the others are interpolated
+    if (entity == _playerEntity)
+    {
+        _predictor.correct(pos.x, pos.y);
+    }
     _updateComponents<components::velocity>(entity, vel);
     _updateComponents<components::health>(entity, {entityState.health});
     _updateComponents<components::update>(entity, {true});
@@ -304,11 +324,15 @@ void Game::_createEntity(const EntityState &entityState)
     switch (static_cast<EntityType>(entityState.entityType))
     {
         case EntityType::PLAYER: {
-            if (entityState.clientId == _networkManager.getClientId())
-                _playerEntity = entity;
-
             components::health health {entityState.health};
             _createPlayer(entity, pos, vel, health);
+
+            // Keep the handle with its generation, the ID may be given to another entity once the player died
+            if (entityState.clientId == _networkManager.getClientId())
+            {
+                _playerEntity = _registry.get_entity(entity);
+                _predictor.reset(pos.x, pos.y);
+            }
             break;
         }
         case EntityType::MOB: {
@@ -566,6 +590,8 @@ void Game::_addSystems()
 {
     _registry.add_system(render_system, _window);
     _registry.add_system(movement_system, _deltaTime);
+    _registry.add_system(interpolation_system, _interpolator, _playerEntity);
+    _registry.add_system(prediction_system, _predictor, _playerEntity);
     _registry.add_system(animation_system, _deltaTime);
     _registry.add_system(animation_event_system, _deltaTime);
     _registry.add_system(collision_system);
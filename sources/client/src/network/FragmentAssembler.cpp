@@ -0,0 +1,54 @@
+#include "network/FragmentAssembler.hpp"
+
+using namespace client;
+
+FragmentAssembler::FragmentAssembler() : _assemblies() {}
+
+FragmentAssembler::~FragmentAssembler() {}
+
+/**
+ * @brief Stores a fragment and rebuilds its message once every fragment of the group was received.
+ *
+ * @param fragment: the fragment received, its payload still in the receive buffer. Duplicates and fragments of an
+ * older group than the one in its slot are dropped
+ * @param message: filled with the whole message when this fragment completed it
+ * @return true if message was filled
+ */
+bool FragmentAssembler::add(const FragmentView &fragment, std::vector<uint8_t> &message)
+{
+    Assembly &assembly = _assemblies[fragment.groupId % FRAGMENT_ASSEMBLY_SLOTS];
+
+    if (fragment.payload.empty())
+        return false;
+
+    if (assembly.groupId != fragment.groupId)
+    {
+        if (fragment.groupId < assembly.groupId)
+            return false;
+
+        // A newer group takes the slot over, whatever was left of the older one is lost
+        assembly.groupId = fragment.groupId;
+        assembly.fragmentCount = fragment.fragmentCount;
+        assembly.received = 0;
+        assembly.payloads.resize(fragment.fragmentCount);
+        for (auto &payload : assembly.payloads)
+        {
+            payload.clear();
+        }
+    }
+
+    if (assembly.fragmentCount != fragment.fragmentCount || !assembly.payloads[fragment.fragmentIndex].empty())
+        return false;
+
+    assembly.payloads[fragment.fragmentIndex].assign(fragment.payload.begin(), fragment.payload.end());
+    if (++assembly.received < assembly.fragmentCount)
+        return false;
+
+    message.clear();
+    for (const auto &payload : assembly.payloads)
+    {
+        message.insert(message.end(), payload.begin(), payload.end());
+    }
+    assembly.fragmentCount = 0;
+    return true;
+}
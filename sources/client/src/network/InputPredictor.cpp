@@ -0,0 +1,128 @@
+#include "network/InputPredictor.hpp"
+
+#include "network/Protocol.hpp"
+
+#include <algorithm>
+
+using namespace client;
+
+InputPredictor::InputPredictor() : _pending() {}
+
+InputPredictor::~InputPredictor() {}
+
+/**
+ * @brief Starts predicting from the given position, e.g. when our player is created.
+ *
+ * The commands still pending are dropped, the acks of the ones sent before are ignored.
+ */
+void InputPredictor::reset(float posX, float posY)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_pending.empty())
+        _acked = _pending.back().sequence;
+    _pending.clear();
+    _posX = posX;
+    _posY = posY;
+    _valid = true;
+}
+
+/**
+ * @brief Applies a command that was just sent to the server.
+ *
+ * @param sequence: the sequence it was sent with, increasing
+ * @param inputFlags: the InputFlags of the command
+ */
+void InputPredictor::push(uint32_t sequence, uint8_t inputFlags)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_valid || sequence <= _acked)
+        return;
+    if (_pending.size() == PREDICTION_MAX_PENDING)
+        _pending.pop_front();
+    _pending.push_back({sequence, inputFlags});
+    applyInput(_posX, _posY, inputFlags);
+}
+
+/**
+ * @brief Reconciles the prediction with the server: rewinds to the acked state, then replays the newer commands.
+ *
+ * @param sequence: the last command the server applied
+ * @param posX, posY: our player's position on the server once it was applied
+ */
+void InputPredictor::acknowledge(uint32_t sequence, float posX, float posY)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Older than the last ack, reordered on the way
+    if (!_valid || sequence < _acked)
+        return;
+
+    _acked = sequence;
+    while (!_pending.empty() && _pending.front().sequence <= sequence)
+    {
+        _pending.pop_front();
+    }
+
+    _posX = posX;
+    _posY = posY;
+    for (const Command &command : _pending)
+    {
+        applyInput(_posX, _posY, command.inputFlags);
+    }
+}
+
+/**
+ * @brief Takes our player's position from a snapshot, when every command sent was acked.
+ *
+ * With commands pending, the snapshot doesn't include them yet: the next ack corrects the prediction instead.
+ */
+void InputPredictor::correct(float posX, float posY)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_valid || !_pending.empty())
+        return;
+    _posX = posX;
+    _posY = posY;
+}
+
+/**
+ * @brief The predicted position of our player.
+ *
+ * @return false if there is no prediction yet (no reset since the start)
+ */
+bool InputPredictor::position(float &posX, float &posY) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_valid)
+        return false;
+    posX = _posX;
+    posY = _posY;
+    return true;
+}
+
+/**
+ * @brief Moves a player by one command, the way the server does.
+ *
+ * The server applies the command (processUserInput), then clamps x and wraps y around the world.
+ */
+void InputPredictor::applyInput(float &posX, float &posY, uint8_t inputFlags)
+{
+    if (inputFlags & static_cast<uint8_t>(InputFlags::MoveUp))
+        posY -= PREDICTION_STEP;
+    if (inputFlags & static_cast<uint8_t>(InputFlags::MoveDown))
+        posY += PREDICTION_STEP;
+    if (inputFlags & static_cast<uint8_t>(InputFlags::MoveLeft))
+        posX -= PREDICTION_STEP * 2;
+    if (inputFlags & static_cast<uint8_t>(InputFlags::MoveRight))
+        posX += PREDICTION_STEP * 2;
+
+    posX = std::clamp(posX, 0.0f, PREDICTION_WORLD_WIDTH - PREDICTION_PLAYER_WIDTH);
+    if (posY < 0.0f)
+        posY = PREDICTION_WORLD_HEIGHT;
+    else if (posY > PREDICTION_WORLD_HEIGHT)
+        posY = 0.0f;
+}
@@ -3,6 +3,9 @@
 #include "network/Protocol.hpp"
 #include "utils/dotenv.h"
 
+#include <algorithm>
+#include <iterator>
+
 using namespace client;
 
 /**
@@ -11,8 +14,8 @@ using namespace client;
  * The server endpoint is set to the values from the .env file.
  */
 NetworkManager::NetworkManager(float &deltaTime)
-    : _clientSocket(_io_context), _recv_buffer(2308), _isConnected(false), _updateInterval(0.016f), _updateTimer(0.0f),
-      _deltaTime(deltaTime), _update(true)
+    : _clientSocket(_io_context), _recv_buffer(MAX_MESSAGE_SIZE), _controlTimer(_io_context), _isConnected(false),
+      _updateInterval(0.016f), _updateTimer(0.0f), _deltaTime(deltaTime), _update(true)
 {
     // dotenv::init();
     // std::string host = dotenv::getenv("SERVER_HOST");
@@ -42,7 +45,7 @@ NetworkManager::~NetworkManager()
  * @brief Connects to the server and sends a ConnectMessage.
  * 
  * The client ID is generated and stored in the _clientId member variable.
- * The client socket is opened and a ConnectMessage is sent to the server.
+ * The client socket is opened and a ConnectMessage is sent to the server, on the reliable channel.
  * The _isConnected flag is set to true.
  * The startReceive method is called to start receiving messages from the server.
  * A new thread is created to run the Asio I/O context.
@@ -63,12 +66,13 @@ void NetworkManager::connectToServer()
     std::vector<uint8_t> buffer;
     serializeConnectMessage(connectMsg, buffer);
 
-    _clientSocket.send_to(asio::buffer(buffer), _serverEndpoint);
+    _sendControl(std::move(buffer));
 
     _isConnected = true;
 
     // Start receiving messages
     startReceive();
+    _startControlTimer();
 
     _receiveThread = std::thread([this]() { run(); });
     // std::cout << "Connected to server with clientId: " << clientId_ << std::endl;
@@ -77,7 +81,8 @@ void NetworkManager::connectToServer()
 /**
  * @brief Disconnects from the server and sends a DisconnectMessage.
  * 
- * The client socket is closed and a DisconnectMessage is sent to the server.
+ * A DisconnectMessage is sent to the server, on the reliable channel: we wait up to DISCONNECT_ACK_TIMEOUT_MS for
+ * its ack (or for anything sent before it).
  * The _isConnected flag is set to false.
  * The client socket is closed.
  */
@@ -94,7 +99,12 @@ void NetworkManager::disconnectFromServer()
         std::vector<uint8_t> buffer;
         serializeDisconnectMessage(disconnectMsg, buffer);
 
-        _clientSocket.send_to(asio::buffer(buffer), _serverEndpoint);
+        _sendControl(std::move(buffer));
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(DISCONNECT_ACK_TIMEOUT_MS);
+        while (!_controlIdle && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
 
         _isConnected = false;
         _clientSocket.close();
@@ -107,25 +117,46 @@ void NetworkManager::disconnectFromServer()
 
 /**
  * @brief Sends user input as a UserInputMessage to the server.
+ * The lobby inputs (StartGame, KickPlayer) go on the reliable channel. The others are input commands, sent at the
+ * input rate: they are numbered so the server can ack them, our player is predicted from those acks. Each one also
+ * carries the previous INPUT_REDUNDANCY commands, the server recovers a lost one from the next messages.
  * @param inputFlags Flags representing user inputs.
+ * @return The sequence of the command, 0 for a lobby input or if not connected.
  */
-void NetworkManager::sendUserInput(uint8_t inputFlags)
+uint32_t NetworkManager::sendUserInput(uint8_t inputFlags)
 {
     if (!_isConnected)
-        return;
+        return 0;
 
+    bool lobby =
+        inputFlags & (static_cast<uint8_t>(InputFlags::StartGame) | static_cast<uint8_t>(InputFlags::KickPlayer));
     UserInputMessage inputMsg = {
         {static_cast<uint16_t>(MessageType::UserInput), sizeof(UserInputMessage)},
         _clientId,
-        static_cast<uint8_t>(inputFlags)
+        lobby ? 0 : ++_inputSequence,
+        static_cast<uint8_t>(inputFlags),
+        {}
     };
 
+    if (!lobby)
+    {
+        std::copy(_previousInputs.begin(), _previousInputs.end(), inputMsg.previousFlags);
+        std::copy_backward(_previousInputs.begin(), _previousInputs.end() - 1, _previousInputs.end());
+        _previousInputs[0] = inputFlags;
+    }
+
     std::vector<uint8_t> buffer;
     serializeUserInputMessage(inputMsg, buffer);
 
     // std::cout << "Sending input flags: " << static_cast<uint8_t>(inputFlags) << std::endl;
 
+    if (lobby)
+    {
+        _sendControl(std::move(buffer));
+        return 0;
+    }
     _clientSocket.send_to(asio::buffer(buffer), _serverEndpoint);
+    return inputMsg.sequence;
 }
 
 /**
@@ -146,8 +177,8 @@ void NetworkManager::startReceive()
                                      [this](const asio::error_code &error, std::size_t bytesReceived) {
         if (!error && bytesReceived > 0)
         {
-            std::vector<uint8_t> data(_recv_buffer.begin(), _recv_buffer.begin() + bytesReceived);
-            _processReceivedMessage(data);
+            // Decoded in place, the next receive isn't started before this one is processed
+            _processReceivedMessage(std::span<const uint8_t>(_recv_buffer.data(), bytesReceived));
         } else if (error)
         {
             std::cerr << "Error receiving message: " << error.message() << std::endl;
@@ -164,9 +195,9 @@ void NetworkManager::startReceive()
 
 /**
  * @brief Processes received messages based on their type.
- * @param data The buffer containing the received message.
+ * @param data The bytes of the received message, read in place: only the entities kept by the game are copied.
  */
-void NetworkManager::_processReceivedMessage(const std::vector<uint8_t> &data)
+void NetworkManager::_processReceivedMessage(std::span<const uint8_t> data)
 {
     MessageHeader header;
     deserializeMessageHeader(data, header);
@@ -184,11 +215,49 @@ void NetworkManager::_processReceivedMessage(const std::vector<uint8_t> &data)
         }
         case MessageType::StateUpdate: {
             std::cout << "Received StateUpdateMessage!" << std::endl;
-            StateUpdateMessage stateMsg;
-            deserializeStateUpdateMessage(data, stateMsg);
+            StateUpdateView stateView;
+            deserializeStateUpdateMessage(data, stateView);
             // std::cout << "Update message received" << std::endl;
 
-            _handleStateUpdate(stateMsg);
+            _stateMsg.header = stateView.header;
+            _stateMsg.numEntities = stateView.numEntities;
+            _stateMsg.entities.assign(stateView.entities.begin(), stateView.entities.end());
+            _stateMsg.destroyedEntities.clear();
+            _handleStateUpdate(_stateMsg);
+            break;
+        }
+        case MessageType::DeltaStateUpdate: {
+            deserializeDeltaStateUpdateMessage(data, _deltaMsg);
+
+            _handleDeltaStateUpdate(_deltaMsg);
+            break;
+        }
+        case MessageType::Fragment: {
+            FragmentView fragmentView;
+            deserializeFragmentMessage(data, fragmentView);
+
+            // Once its last fragment is in, the message is handled like any other
+            if (_fragments.add(fragmentView, _assembled))
+            {
+                _processReceivedMessage(_assembled);
+            }
+            break;
+        }
+        case MessageType::Reliable: {
+            ReliableView reliableMsg;
+            deserializeReliableMessage(data, reliableMsg);
+
+            _handleReliable(reliableMsg);
+            break;
+        }
+        case MessageType::InputAck: {
+            InputAckMessage ackMsg;
+            deserializeInputAckMessage(data, ackMsg);
+
+            if (ackMsg.clientId == _clientId && _inputAckCallback)
+            {
+                _inputAckCallback(ackMsg);
+            }
             break;
         }
         case MessageType::GameOver: {
@@ -215,6 +284,27 @@ void NetworkManager::setGameOverCallback(GameOverCallback callback)
     _gameOverCallback = callback;
 }
 
+void NetworkManager::setInputAckCallback(InputAckCallback callback)
+{
+    _inputAckCallback = callback;
+}
+
+/**
+ * @brief Sets how many input commands are sent per second.
+ *
+ * Higher rates move our player faster (each command is a step) and cost more upstream packets.
+ * @param rate Commands per second, at least 1.
+ */
+void NetworkManager::setInputRate(unsigned int rate)
+{
+    _inputRate = std::max(rate, 1u);
+}
+
+unsigned int NetworkManager::getInputRate() const
+{
+    return _inputRate;
+}
+
 /**
  * @brief Handles a StateUpdateMessage by updating the local game state.
  * @param stateMsg The state update message from the server.
@@ -252,6 +342,150 @@ void NetworkManager::_handleStateUpdate(const StateUpdateMessage &stateMsg)
     }
 }
 
+/**
+ * @brief Rebuilds the snapshot sent as a delta, acks it and hands it to the game as a StateUpdateMessage.
+ *
+ * Snapshots older than the last one handed to the game (reordered or duplicated datagrams) are dropped,
+ * so are the ones whose baseline is not known anymore: the server keeps sending relative to our last ack.
+ *
+ * @param deltaMsg The delta state update message from the server.
+ */
+void NetworkManager::_handleDeltaStateUpdate(const DeltaStateUpdateMessage &deltaMsg)
+{
+    if (deltaMsg.sequence <= _lastSequence)
+        return;
+
+    const std::vector<EntityState> *entities = _snapshots.apply(deltaMsg);
+    if (entities == nullptr)
+        return;
+
+    _sendSnapshotAck(deltaMsg.sequence);
+    _lastSequence = deltaMsg.sequence;
+
+    // The game expects the whole state, plus the entities that disappeared since the last one it got
+    _stateMsg.header = {static_cast<uint16_t>(MessageType::StateUpdate), deltaMsg.header.messageSize};
+    _stateMsg.numEntities = static_cast<uint32_t>(entities->size());
+    _stateMsg.entities.assign(entities->begin(), entities->end());
+
+    std::vector<uint32_t> liveEntities;
+    liveEntities.reserve(entities->size());
+    for (const auto &entity : *entities)
+    {
+        liveEntities.push_back(entity.entityId);
+    }
+    _stateMsg.destroyedEntities.clear();
+    std::set_difference(_liveEntities.begin(), _liveEntities.end(), liveEntities.begin(), liveEntities.end(),
+                        std::back_inserter(_stateMsg.destroyedEntities));
+    _liveEntities.swap(liveEntities);
+
+    _handleStateUpdate(_stateMsg);
+}
+
+/**
+ * @brief Tells the server the last snapshot we rebuilt, the next ones are sent relative to it.
+ * @param sequence The sequence of the snapshot.
+ */
+void NetworkManager::_sendSnapshotAck(uint32_t sequence)
+{
+    SnapshotAckMessage ackMsg = {
+        {static_cast<uint16_t>(MessageType::SnapshotAck), sizeof(SnapshotAckMessage)},
+        _clientId,
+        sequence
+    };
+
+    std::vector<uint8_t> buffer;
+    serializeSnapshotAckMessage(ackMsg, buffer);
+
+    _clientSocket.send_to(asio::buffer(buffer), _serverEndpoint);
+}
+
+/**
+ * @brief Sends a serialized control message on the reliable channel, it is resent until the server acks it.
+ * Callable from any thread, the channel is only touched on the network thread.
+ * @param message The serialized control message.
+ */
+void NetworkManager::_sendControl(std::vector<uint8_t> message)
+{
+    _controlIdle = false;
+    asio::post(_io_context, [this, message = std::move(message)]() {
+        _control.push(message);
+        _flushControl();
+    });
+}
+
+/**
+ * @brief Sends the control messages due: the new ones and the ones not acked in time.
+ */
+void NetworkManager::_flushControl()
+{
+    _control.resend(ReliableChannel::Clock::now(), [this](uint32_t sequence, std::span<const uint8_t> message) {
+        uint32_t ack = _control.lastReceived();
+        ReliableMessage reliableMsg = {
+            {static_cast<uint16_t>(MessageType::Reliable), 0},
+            _clientId, sequence, ack, _control.ackBits(ack), std::vector<uint8_t>(message.begin(), message.end())
+        };
+
+        _sendReliable(reliableMsg);
+    });
+}
+
+/**
+ * @brief Flushes the control messages every RELIABLE_RESEND_MS while connected.
+ */
+void NetworkManager::_startControlTimer()
+{
+    _controlTimer.expires_after(std::chrono::milliseconds(RELIABLE_RESEND_MS));
+    _controlTimer.async_wait([this](const asio::error_code &error) {
+        if (error || !_isConnected)
+            return;
+        _flushControl();
+        _startControlTimer();
+    });
+}
+
+/**
+ * @brief Sends a ReliableMessage, errors are left to the resends.
+ * @param reliableMsg The message, an ack alone or a control message.
+ */
+void NetworkManager::_sendReliable(const ReliableMessage &reliableMsg)
+{
+    std::vector<uint8_t> buffer;
+    asio::error_code error;
+
+    serializeReliableMessage(reliableMsg, buffer);
+    _clientSocket.send_to(asio::buffer(buffer), _serverEndpoint, 0, error);
+}
+
+/**
+ * @brief Takes the acks of a ReliableMessage, acks it and processes the control messages it made ready, in order.
+ * @param reliableMsg The message received, its payload still in the receive buffer.
+ */
+void NetworkManager::_handleReliable(const ReliableView &reliableMsg)
+{
+    auto deliver = [this](std::span<const uint8_t> message) {
+        MessageHeader header;
+        deserializeMessageHeader(message, header);
+        // never nested
+        if (static_cast<MessageType>(header.messageType) != MessageType::Reliable)
+        {
+            _processReceivedMessage(message);
+        }
+    };
+
+    _control.acknowledge(reliableMsg.ack, reliableMsg.ackBits);
+    bool received = _control.receive(reliableMsg.sequence, reliableMsg.payload, deliver);
+
+    if (received)
+    {
+        ReliableMessage ackMsg = {
+            {static_cast<uint16_t>(MessageType::Reliable), RELIABLE_HEADER_SIZE},
+            _clientId, 0, reliableMsg.sequence, _control.ackBits(reliableMsg.sequence), {}
+        };
+        _sendReliable(ackMsg);
+    }
+    _controlIdle = _control.idle();
+}
+
 /**
  * @brief Runs the Asio I/O context.
  */
@@ -1,11 +1,135 @@
 #include "network/Protocol.hpp"
+#include "network/BitStream.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <stdexcept>
 
 using namespace client;
 
+// Appends the raw bytes of value (already in network order) to the buffer
+template <typename T> static void appendBytes(std::vector<uint8_t> &buffer, const T &value)
+{
+    buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&value),
+                  reinterpret_cast<const uint8_t *>(&value) + sizeof(T));
+}
+
+// Reads the raw bytes of value at offset and moves past them
+template <typename T>
+static void readBytes(std::span<const uint8_t> buffer, size_t &offset, T &value, const char *error)
+{
+    if (offset + sizeof(T) > buffer.size())
+        throw std::runtime_error(error);
+    memcpy(&value, buffer.data() + offset, sizeof(T));
+    offset += sizeof(T);
+}
+
+static bool hasField(uint8_t fieldMask, EntityField field)
+{
+    return (fieldMask & static_cast<uint8_t>(field)) != 0;
+}
+
+// Fixed point position, clamped to the WIRE_POS_BITS window starting at min
+static uint32_t quantizePosition(float value, float min)
+{
+    long limit = (1L << WIRE_POS_BITS) - 1;
+
+    return static_cast<uint32_t>(std::clamp(std::lround((value - min) * WIRE_FIXED_SCALE), 0L, limit));
+}
+
+static float dequantizePosition(uint32_t value, float min)
+{
+    return min + static_cast<float>(value) / WIRE_FIXED_SCALE;
+}
+
+// Fixed point velocity, two's complement on WIRE_VEL_BITS
+static uint32_t quantizeVelocity(float value)
+{
+    long limit = 1L << (WIRE_VEL_BITS - 1);
+    long fixed = std::clamp(std::lround(value * WIRE_FIXED_SCALE), -limit, limit - 1);
+
+    return static_cast<uint32_t>(fixed) & ((1u << WIRE_VEL_BITS) - 1);
+}
+
+static float dequantizeVelocity(uint32_t value)
+{
+    // Sign extends from WIRE_VEL_BITS
+    int32_t fixed = static_cast<int32_t>(value << (32 - WIRE_VEL_BITS)) >> (32 - WIRE_VEL_BITS);
+
+    return static_cast<float>(fixed) / WIRE_FIXED_SCALE;
+}
+
+// Created entity after its id: type, health, position, velocity, then clientId for players only
+static void writeCreatedEntity(BitWriter &writer, const EntityState &state)
+{
+    writer.write(static_cast<uint32_t>(state.entityType), WIRE_TYPE_BITS);
+    writer.write(state.health, WIRE_HEALTH_BITS);
+    writer.write(quantizePosition(state.posX, WIRE_POS_MIN_X), WIRE_POS_BITS);
+    writer.write(quantizePosition(state.posY, WIRE_POS_MIN_Y), WIRE_POS_BITS);
+    writer.write(quantizeVelocity(state.velX), WIRE_VEL_BITS);
+    writer.write(quantizeVelocity(state.velY), WIRE_VEL_BITS);
+    if (state.entityType == EntityType::PLAYER)
+        writer.write(state.clientId, 32);
+}
+
+static void readCreatedEntity(BitReader &reader, EntityState &state)
+{
+    state.entityType = static_cast<EntityType>(reader.read(WIRE_TYPE_BITS));
+    state.health = static_cast<uint8_t>(reader.read(WIRE_HEALTH_BITS));
+    state.posX = dequantizePosition(reader.read(WIRE_POS_BITS), WIRE_POS_MIN_X);
+    state.posY = dequantizePosition(reader.read(WIRE_POS_BITS), WIRE_POS_MIN_Y);
+    state.velX = dequantizeVelocity(reader.read(WIRE_VEL_BITS));
+    state.velY = dequantizeVelocity(reader.read(WIRE_VEL_BITS));
+    state.clientId = (state.entityType == EntityType::PLAYER) ? reader.read(32) : NO_CLIENT_ID;
+}
+
+// Updated entity after its id: field mask, then only the fields set in the mask
+static void writeUpdatedEntity(BitWriter &writer, const EntityDelta &delta)
+{
+    const EntityState &state = delta.state;
+
+    writer.write(delta.fieldMask, WIRE_FIELD_MASK_BITS);
+    if (hasField(delta.fieldMask, EntityField::ClientId))
+        writer.write(state.clientId, 32);
+    if (hasField(delta.fieldMask, EntityField::PosX))
+        writer.write(quantizePosition(state.posX, WIRE_POS_MIN_X), WIRE_POS_BITS);
+    if (hasField(delta.fieldMask, EntityField::PosY))
+        writer.write(quantizePosition(state.posY, WIRE_POS_MIN_Y), WIRE_POS_BITS);
+    if (hasField(delta.fieldMask, EntityField::VelX))
+        writer.write(quantizeVelocity(state.velX), WIRE_VEL_BITS);
+    if (hasField(delta.fieldMask, EntityField::VelY))
+        writer.write(quantizeVelocity(state.velY), WIRE_VEL_BITS);
+    if (hasField(delta.fieldMask, EntityField::EntityType))
+        writer.write(static_cast<uint32_t>(state.entityType), WIRE_TYPE_BITS);
+    if (hasField(delta.fieldMask, EntityField::Health))
+        writer.write(state.health, WIRE_HEALTH_BITS);
+}
+
+static void readUpdatedEntity(BitReader &reader, EntityDelta &delta)
+{
+    EntityState &state = delta.state;
+
+    delta.fieldMask = static_cast<uint8_t>(reader.read(WIRE_FIELD_MASK_BITS));
+    if (hasField(delta.fieldMask, EntityField::ClientId))
+        state.clientId = reader.read(32);
+    if (hasField(delta.fieldMask, EntityField::PosX))
+        state.posX = dequantizePosition(reader.read(WIRE_POS_BITS), WIRE_POS_MIN_X);
+    if (hasField(delta.fieldMask, EntityField::PosY))
+        state.posY = dequantizePosition(reader.read(WIRE_POS_BITS), WIRE_POS_MIN_Y);
+    if (hasField(delta.fieldMask, EntityField::VelX))
+        state.velX = dequantizeVelocity(reader.read(WIRE_VEL_BITS));
+    if (hasField(delta.fieldMask, EntityField::VelY))
+        state.velY = dequantizeVelocity(reader.read(WIRE_VEL_BITS));
+    if (hasField(delta.fieldMask, EntityField::EntityType))
+        state.entityType = static_cast<EntityType>(reader.read(WIRE_TYPE_BITS));
+    if (hasField(delta.fieldMask, EntityField::Health))
+        state.health = static_cast<uint8_t>(reader.read(WIRE_HEALTH_BITS));
+}
+
 // Serialize the common message header (header and buffer)
 void client::serializeMessageHeader(const MessageHeader &header, std::vector<uint8_t> &buffer)
 {
@@ -60,6 +184,165 @@ void client::serializeStateUpdateMessage(const StateUpdateMessage &msg, std::vec
     }
 }
 
+// Serialize DeltaStateUpdateMessage, the size in the header is computed from what was written
+void client::serializeDeltaStateUpdateMessage(const DeltaStateUpdateMessage &msg, std::vector<uint8_t> &buffer)
+{
+    size_t start = buffer.size();
+    client::serializeMessageHeader(msg.header, buffer);
+
+    appendBytes(buffer, htonl(msg.sequence));
+    appendBytes(buffer, htonl(msg.baseSequence));
+    appendBytes(buffer, htons(static_cast<uint16_t>(msg.created.size())));
+    appendBytes(buffer, htons(static_cast<uint16_t>(msg.updated.size())));
+    appendBytes(buffer, htons(static_cast<uint16_t>(msg.destroyed.size())));
+
+    // Bit-packed body, each list is sorted by id so only the gap from the previous id is written
+    BitWriter writer(buffer);
+    uint32_t previousId = 0;
+    for (const auto &entity : msg.created)
+    {
+        writer.writeVarint(entity.entityId - previousId);
+        writeCreatedEntity(writer, entity);
+        previousId = entity.entityId;
+    }
+    previousId = 0;
+    for (const auto &delta : msg.updated)
+    {
+        writer.writeVarint(delta.state.entityId - previousId);
+        writeUpdatedEntity(writer, delta);
+        previousId = delta.state.entityId;
+    }
+    previousId = 0;
+    for (uint32_t entityId : msg.destroyed)
+    {
+        writer.writeVarint(entityId - previousId);
+        previousId = entityId;
+    }
+    writer.flush();
+
+    // Patch the real message size in the header
+    uint16_t size = htons(static_cast<uint16_t>(buffer.size() - start));
+    memcpy(buffer.data() + start + sizeof(uint16_t), &size, sizeof(size));
+}
+
+void client::quantizeEntityState(EntityState &state)
+{
+    state.posX = dequantizePosition(quantizePosition(state.posX, WIRE_POS_MIN_X), WIRE_POS_MIN_X);
+    state.posY = dequantizePosition(quantizePosition(state.posY, WIRE_POS_MIN_Y), WIRE_POS_MIN_Y);
+    state.velX = dequantizeVelocity(quantizeVelocity(state.velX));
+    state.velY = dequantizeVelocity(quantizeVelocity(state.velY));
+    if (state.entityType != EntityType::PLAYER)
+        state.clientId = NO_CLIENT_ID;
+}
+
+size_t client::createdEntityBits(const EntityState &state)
+{
+    size_t bits = varintBits(state.entityId) + WIRE_TYPE_BITS + WIRE_HEALTH_BITS;
+
+    bits += 2 * WIRE_POS_BITS + 2 * WIRE_VEL_BITS;
+    if (state.entityType == EntityType::PLAYER)
+        bits += 32;
+    return bits;
+}
+
+size_t client::updatedEntityBits(const EntityDelta &delta)
+{
+    size_t bits = varintBits(delta.state.entityId) + WIRE_FIELD_MASK_BITS;
+
+    if (hasField(delta.fieldMask, EntityField::ClientId))
+        bits += 32;
+    if (hasField(delta.fieldMask, EntityField::PosX))
+        bits += WIRE_POS_BITS;
+    if (hasField(delta.fieldMask, EntityField::PosY))
+        bits += WIRE_POS_BITS;
+    if (hasField(delta.fieldMask, EntityField::VelX))
+        bits += WIRE_VEL_BITS;
+    if (hasField(delta.fieldMask, EntityField::VelY))
+        bits += WIRE_VEL_BITS;
+    if (hasField(delta.fieldMask, EntityField::EntityType))
+        bits += WIRE_TYPE_BITS;
+    if (hasField(delta.fieldMask, EntityField::Health))
+        bits += WIRE_HEALTH_BITS;
+    return bits;
+}
+
+size_t client::serializedDeltaStateUpdateSize(const DeltaStateUpdateMessage &msg)
+{
+    size_t bits = 0;
+    uint32_t previousId = 0;
+
+    // Same id gaps as serializeDeltaStateUpdateMessage, so the size is exact
+    for (const auto &entity : msg.created)
+    {
+        bits += createdEntityBits(entity) - varintBits(entity.entityId) + varintBits(entity.entityId - previousId);
+        previousId = entity.entityId;
+    }
+    previousId = 0;
+    for (const auto &delta : msg.updated)
+    {
+        uint32_t entityId = delta.state.entityId;
+
+        bits += updatedEntityBits(delta) - varintBits(entityId) + varintBits(entityId - previousId);
+        previousId = entityId;
+    }
+    previousId = 0;
+    for (uint32_t entityId : msg.destroyed)
+    {
+        bits += varintBits(entityId - previousId);
+        previousId = entityId;
+    }
+    return DELTA_STATE_UPDATE_HEADER_SIZE + (bits + 7) / 8;
+}
+
+// Serialize FragmentMessage, the size in the header is computed from the payload
+void client::serializeFragmentMessage(const FragmentMessage &msg, std::vector<uint8_t> &buffer)
+{
+    MessageHeader header = {msg.header.messageType,
+                            static_cast<uint16_t>(FRAGMENT_HEADER_SIZE + msg.payload.size())};
+
+    client::serializeMessageHeader(header, buffer);
+
+    appendBytes(buffer, htonl(msg.groupId));
+    buffer.push_back(msg.fragmentIndex);
+    buffer.push_back(msg.fragmentCount);
+    buffer.insert(buffer.end(), msg.payload.begin(), msg.payload.end());
+}
+
+// Serialize ReliableMessage, the size in the header is computed from the payload
+void client::serializeReliableMessage(const ReliableMessage &msg, std::vector<uint8_t> &buffer)
+{
+    MessageHeader header = {msg.header.messageType,
+                            static_cast<uint16_t>(RELIABLE_HEADER_SIZE + msg.payload.size())};
+
+    client::serializeMessageHeader(header, buffer);
+
+    appendBytes(buffer, htonl(msg.clientId));
+    appendBytes(buffer, htonl(msg.sequence));
+    appendBytes(buffer, htonl(msg.ack));
+    appendBytes(buffer, htonl(msg.ackBits));
+    buffer.insert(buffer.end(), msg.payload.begin(), msg.payload.end());
+}
+
+// Serialize InputAckMessage, the position is sent as the bits of the floats
+void client::serializeInputAckMessage(const InputAckMessage &msg, std::vector<uint8_t> &buffer)
+{
+    client::serializeMessageHeader(msg.header, buffer);
+
+    appendBytes(buffer, htonl(msg.clientId));
+    appendBytes(buffer, htonl(msg.sequence));
+    appendBytes(buffer, htonl(std::bit_cast<uint32_t>(msg.posX)));
+    appendBytes(buffer, htonl(std::bit_cast<uint32_t>(msg.posY)));
+}
+
+// Serialize SnapshotAckMessage
+void client::serializeSnapshotAckMessage(const SnapshotAckMessage &msg, std::vector<uint8_t> &buffer)
+{
+    client::serializeMessageHeader(msg.header, buffer);
+
+    appendBytes(buffer, htonl(msg.clientId));
+    appendBytes(buffer, htonl(msg.sequence));
+}
+
 // !THIS IS A EXAMPLE FOR THE CLINENT
 
 // Example  on how to send input message... (construct header + msessage and join the flags via bitwise OR)
@@ -77,13 +360,15 @@ void client::serializeUserInputMessage(const UserInputMessage &msg, std::vector<
     buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&clientId),
                   reinterpret_cast<const uint8_t *>(&clientId) + sizeof(clientId));
 
+    appendBytes(buffer, htonl(msg.sequence));
     buffer.push_back(msg.inputFlags);
+    buffer.insert(buffer.end(), msg.previousFlags, msg.previousFlags + INPUT_REDUNDANCY);
 }
 
 // ! Deserialize the common message header -> used by the client and client
 
 // Deserialize MessageHeader
-void client::deserializeMessageHeader(const std::vector<uint8_t> &buffer, MessageHeader &header)
+void client::deserializeMessageHeader(std::span<const uint8_t> buffer, MessageHeader &header)
 {
     if (buffer.size() < sizeof(MessageHeader))
         throw std::runtime_error("Buffer too small for header");
@@ -96,7 +381,7 @@ void client::deserializeMessageHeader(const std::vector<uint8_t> &buffer, Messag
 
 // Deserialize ConnectMessage -> take the bytes and memcopp to the structe sru dta an sizeof the
 // the src is the startign point for that so the point  buffer + already filled
-void client::deserializeConnectMessage(const std::vector<uint8_t> &buffer, ConnectMessage &msg)
+void client::deserializeConnectMessage(std::span<const uint8_t> buffer, ConnectMessage &msg)
 {
     client::deserializeMessageHeader(buffer, msg.header);
 
@@ -109,7 +394,7 @@ void client::deserializeConnectMessage(const std::vector<uint8_t> &buffer, Conne
 }
 
 // Deserialize DisconnectMessage
-void client::deserializeDisconnectMessage(const std::vector<uint8_t> &buffer, DisconnectMessage &msg)
+void client::deserializeDisconnectMessage(std::span<const uint8_t> buffer, DisconnectMessage &msg)
 {
     client::deserializeMessageHeader(buffer, msg.header);
 
@@ -120,51 +405,53 @@ void client::deserializeDisconnectMessage(const std::vector<uint8_t> &buffer, Di
     msg.clientId = ntohl(msg.clientId);
 }
 
-// Deserialize StateUpdateMessage (CLIENT)
-void client::deserializeStateUpdateMessage(const std::vector<uint8_t> &buffer, StateUpdateMessage &msg)
+// Deserialize StateUpdateMessage (CLIENT), the entities are checked to fit in the buffer but not decoded
+void client::deserializeStateUpdateMessage(std::span<const uint8_t> buffer, StateUpdateView &view)
 {
-    client::deserializeMessageHeader(buffer, msg.header);
+    const char *error = "Buffer too small for StateUpdateMessage";
+    size_t offset = sizeof(MessageHeader);
 
-    if (buffer.size() < sizeof(MessageHeader) + sizeof(uint32_t))  // each state has the num of entites
-        throw std::runtime_error("Buffer too small for StateUpdateMessage");
+    client::deserializeMessageHeader(buffer, view.header);
 
-    memcpy(&msg.numEntities, buffer.data() + sizeof(MessageHeader), sizeof(uint32_t));
-    msg.numEntities = ntohl(msg.numEntities);
+    readBytes(buffer, offset, view.numEntities, error);
+    view.numEntities = ntohl(view.numEntities);
 
-    size_t offset = sizeof(MessageHeader) + sizeof(uint32_t);  // header + num of entiites
-    for (uint32_t i = 0; i < msg.numEntities; ++i)
-    {
-        if (offset + sizeof(EntityState) > buffer.size())
-            throw std::runtime_error("Buffer too small for EntityState");
+    size_t entitiesSize = size_t(view.numEntities) * sizeof(EntityState);
+    if (entitiesSize > buffer.size() - offset)
+        throw std::runtime_error("Buffer too small for EntityState");
+    view.entities = EntityStateRange(buffer.subspan(offset, entitiesSize));
+}
 
-        EntityState entity;
-        memcpy(&entity, buffer.data() + offset, sizeof(EntityState));
-        msg.entities.push_back(entity);  // push_back to the entities vector -> (will be client thing this)
-        offset += sizeof(EntityState);
-    }
+void client::deserializeStateUpdateMessage(std::span<const uint8_t> buffer, StateUpdateMessage &msg)
+{
+    StateUpdateView view;
+
+    client::deserializeStateUpdateMessage(buffer, view);
+    msg.header = view.header;
+    msg.numEntities = view.numEntities;
+    msg.entities.assign(view.entities.begin(), view.entities.end());
 }
 
 // Deserialize UserInputMessage SERVER
-void client::deserializeUserInputMessage(const std::vector<uint8_t> &buffer, UserInputMessage &msg)
+void client::deserializeUserInputMessage(std::span<const uint8_t> buffer, UserInputMessage &msg)
 {
-    client::deserializeMessageHeader(buffer, msg.header);
+    const char *error = "Buffer too small for UserInputMessage";
+    size_t offset = sizeof(MessageHeader);
 
-    if (buffer.size() < sizeof(MessageHeader) + sizeof(uint32_t) + sizeof(uint8_t))
-        throw std::runtime_error("Buffer too small for UserInputMessage");
+    client::deserializeMessageHeader(buffer, msg.header);
 
-    memcpy(&msg.clientId, buffer.data() + sizeof(MessageHeader), sizeof(uint32_t));
+    readBytes(buffer, offset, msg.clientId, error);
+    readBytes(buffer, offset, msg.sequence, error);
+    readBytes(buffer, offset, msg.inputFlags, error);
+    readBytes(buffer, offset, msg.previousFlags, error);
     msg.clientId = ntohl(msg.clientId);
-
-    // could use this but since is the last byte we just get the last byte of the buffer
-    // memcpy(&msg.inputFlags,buffer.data() + sizeof(MessageHeader) + sizeof(uint32_t), sizeof(uint8_t));
-    msg.inputFlags = buffer[sizeof(MessageHeader) +
-                            sizeof(uint32_t)];  // input flags is the last byte of teh buffer (only 1 byte for now)
+    msg.sequence = ntohl(msg.sequence);
 }
 
 // Deserialize DisconnectMessage
 
 // ----------------- Deserialize ----------------- //
-void client::deserializeGameOverMessage(const std::vector<uint8_t> &buffer, GameOverMessage &msg)
+void client::deserializeGameOverMessage(std::span<const uint8_t> buffer, GameOverMessage &msg)
 {
     // First deserialize the common message header (4 bytes)
     client::deserializeMessageHeader(buffer, msg.header);
@@ -189,3 +476,149 @@ void client::deserializeGameOverMessage(const std::vector<uint8_t> &buffer, Game
     msg.condition = static_cast<GameOverType>(rawCondition);
     offset += sizeof(uint16_t);
 }
+
+// Deserialize DeltaStateUpdateMessage (CLIENT)
+void client::deserializeDeltaStateUpdateMessage(std::span<const uint8_t> buffer, DeltaStateUpdateMessage &msg)
+{
+    const char *error = "Buffer too small for DeltaStateUpdateMessage";
+    size_t offset = sizeof(MessageHeader);
+    uint16_t numCreated;
+    uint16_t numUpdated;
+    uint16_t numDestroyed;
+
+    client::deserializeMessageHeader(buffer, msg.header);
+
+    readBytes(buffer, offset, msg.sequence, error);
+    readBytes(buffer, offset, msg.baseSequence, error);
+    readBytes(buffer, offset, numCreated, error);
+    readBytes(buffer, offset, numUpdated, error);
+    readBytes(buffer, offset, numDestroyed, error);
+    msg.sequence = ntohl(msg.sequence);
+    msg.baseSequence = ntohl(msg.baseSequence);
+
+    // Ids are sent as gaps from the previous id of the list
+    BitReader reader(buffer, offset);
+    uint32_t entityId = 0;
+    msg.created.resize(ntohs(numCreated));
+    for (auto &entity : msg.created)
+    {
+        entityId += reader.readVarint();
+        entity.entityId = entityId;
+        readCreatedEntity(reader, entity);
+    }
+
+    entityId = 0;
+    msg.updated.resize(ntohs(numUpdated));
+    for (auto &delta : msg.updated)
+    {
+        entityId += reader.readVarint();
+        delta.state = {};
+        delta.state.entityId = entityId;
+        readUpdatedEntity(reader, delta);
+    }
+
+    entityId = 0;
+    msg.destroyed.resize(ntohs(numDestroyed));
+    for (auto &destroyedId : msg.destroyed)
+    {
+        entityId += reader.readVarint();
+        destroyedId = entityId;
+    }
+}
+
+// Deserialize InputAckMessage (CLIENT)
+void client::deserializeInputAckMessage(std::span<const uint8_t> buffer, InputAckMessage &msg)
+{
+    const char *error = "Buffer too small for InputAckMessage";
+    size_t offset = sizeof(MessageHeader);
+    uint32_t posX;
+    uint32_t posY;
+
+    client::deserializeMessageHeader(buffer, msg.header);
+
+    readBytes(buffer, offset, msg.clientId, error);
+    readBytes(buffer, offset, msg.sequence, error);
+    readBytes(buffer, offset, posX, error);
+    readBytes(buffer, offset, posY, error);
+    msg.clientId = ntohl(msg.clientId);
+    msg.sequence = ntohl(msg.sequence);
+    msg.posX = std::bit_cast<float>(ntohl(posX));
+    msg.posY = std::bit_cast<float>(ntohl(posY));
+}
+
+// Deserialize SnapshotAckMessage SERVER
+void client::deserializeSnapshotAckMessage(std::span<const uint8_t> buffer, SnapshotAckMessage &msg)
+{
+    const char *error = "Buffer too small for SnapshotAckMessage";
+    size_t offset = sizeof(MessageHeader);
+
+    client::deserializeMessageHeader(buffer, msg.header);
+
+    readBytes(buffer, offset, msg.clientId, error);
+    readBytes(buffer, offset, msg.sequence, error);
+    msg.clientId = ntohl(msg.clientId);
+    msg.sequence = ntohl(msg.sequence);
+}
+
+// Deserialize FragmentMessage (CLIENT), the payload is left in the buffer
+void client::deserializeFragmentMessage(std::span<const uint8_t> buffer, FragmentView &view)
+{
+    const char *error = "Buffer too small for FragmentMessage";
+    size_t offset = sizeof(MessageHeader);
+
+    client::deserializeMessageHeader(buffer, view.header);
+
+    readBytes(buffer, offset, view.groupId, error);
+    readBytes(buffer, offset, view.fragmentIndex, error);
+    readBytes(buffer, offset, view.fragmentCount, error);
+    view.groupId = ntohl(view.groupId);
+    if (view.fragmentIndex >= view.fragmentCount)
+        throw std::runtime_error("Invalid fragment index in FragmentMessage");
+
+    view.payload = buffer.subspan(offset);
+}
+
+void client::deserializeFragmentMessage(std::span<const uint8_t> buffer, FragmentMessage &msg)
+{
+    FragmentView view;
+
+    client::deserializeFragmentMessage(buffer, view);
+    msg.header = view.header;
+    msg.groupId = view.groupId;
+    msg.fragmentIndex = view.fragmentIndex;
+    msg.fragmentCount = view.fragmentCount;
+    msg.payload.assign(view.payload.begin(), view.payload.end());
+}
+
+// Deserialize ReliableMessage, the payload is left in the buffer
+void client::deserializeReliableMessage(std::span<const uint8_t> buffer, ReliableView &view)
+{
+    const char *error = "Buffer too small for ReliableMessage";
+    size_t offset = sizeof(MessageHeader);
+
+    client::deserializeMessageHeader(buffer, view.header);
+
+    readBytes(buffer, offset, view.clientId, error);
+    readBytes(buffer, offset, view.sequence, error);
+    readBytes(buffer, offset, view.ack, error);
+    readBytes(buffer, offset, view.ackBits, error);
+    view.clientId = ntohl(view.clientId);
+    view.sequence = ntohl(view.sequence);
+    view.ack = ntohl(view.ack);
+    view.ackBits = ntohl(view.ackBits);
+
+    view.payload = buffer.subspan(offset);
+}
+
+void client::deserializeReliableMessage(std::span<const uint8_t> buffer, ReliableMessage &msg)
+{
+    ReliableView view;
+
+    client::deserializeReliableMessage(buffer, view);
+    msg.header = view.header;
+    msg.clientId = view.clientId;
+    msg.sequence = view.sequence;
+    msg.ack = view.ack;
+    msg.ackBits = view.ackBits;
+    msg.payload.assign(view.payload.begin(), view.payload.end());
+}
@@ -0,0 +1,76 @@
+#include "network/ReliableChannel.hpp"
+
+using namespace client;
+
+ReliableChannel::ReliableChannel() : _pending(), _early() {}
+
+ReliableChannel::~ReliableChannel() {}
+
+/**
+ * @brief Queues a serialized control message, the next resend() sends it.
+ *
+ * @return the sequence of the message
+ */
+uint32_t ReliableChannel::push(std::span<const uint8_t> message)
+{
+    Pending &pending = _pending.emplace_back();
+
+    pending.sequence = _nextSequence++;
+    pending.message.assign(message.begin(), message.end());
+    return pending.sequence;
+}
+
+/**
+ * @brief Drops the messages the server received.
+ *
+ * @param ack: a sequence it received, 0 for none
+ * @param ackBits: bit i set if ack - 1 - i was received too
+ */
+void ReliableChannel::acknowledge(uint32_t ack, uint32_t ackBits)
+{
+    if (ack == 0)
+        return;
+
+    std::erase_if(_pending, [ack, ackBits](const Pending &pending) {
+        uint32_t before = ack - pending.sequence;  // how far before ack, wraps around when after it
+        return before == 0 || (before <= 32 && (ackBits >> (before - 1)) & 1);
+    });
+}
+
+/**
+ * @brief Whether every message was acked.
+ */
+bool ReliableChannel::idle() const
+{
+    return _pending.empty();
+}
+
+/**
+ * @brief Newest sequence received, 0 for none.
+ */
+uint32_t ReliableChannel::lastReceived() const
+{
+    return _lastReceived;
+}
+
+/**
+ * @brief Which of the 32 sequences before ack were received, bit i for ack - 1 - i.
+ */
+uint32_t ReliableChannel::ackBits(uint32_t ack) const
+{
+    uint32_t bits = 0;
+
+    for (uint32_t i = 0; i < 32 && i + 1 < ack; ++i)
+    {
+        if (_received(ack - 1 - i))
+            bits |= 1u << i;
+    }
+    return bits;
+}
+
+bool ReliableChannel::_received(uint32_t sequence) const
+{
+    if (sequence < _nextDelivery)
+        return true;
+    return sequence < _nextDelivery + RELIABLE_WINDOW && _early[sequence % RELIABLE_WINDOW].received;
+}
@@ -0,0 +1,88 @@
+#include "network/SnapshotHistory.hpp"
+
+#include <algorithm>
+
+using namespace client;
+
+SnapshotHistory::SnapshotHistory() : _snapshots(), _scratch() {}
+
+SnapshotHistory::~SnapshotHistory() {}
+
+/**
+ * @brief Copies the fields set in the delta mask into the entity state.
+ */
+static void patchEntity(EntityState &state, const EntityDelta &delta)
+{
+    auto has = [&delta](EntityField field) { return (delta.fieldMask & static_cast<uint8_t>(field)) != 0; };
+
+    if (has(EntityField::ClientId))
+        state.clientId = delta.state.clientId;
+    if (has(EntityField::PosX))
+        state.posX = delta.state.posX;
+    if (has(EntityField::PosY))
+        state.posY = delta.state.posY;
+    if (has(EntityField::VelX))
+        state.velX = delta.state.velX;
+    if (has(EntityField::VelY))
+        state.velY = delta.state.velY;
+    if (has(EntityField::EntityType))
+        state.entityType = delta.state.entityType;
+    if (has(EntityField::Health))
+        state.health = delta.state.health;
+}
+
+/**
+ * @brief Rebuilds the snapshot described by a delta on top of its baseline and stores it.
+ *
+ * @param delta: the delta received from the server, its lists are sorted by entity id
+ * @return the entities of the rebuilt snapshot, nullptr if the baseline is not in the ring anymore
+ */
+const std::vector<EntityState> *SnapshotHistory::apply(const DeltaStateUpdateMessage &delta)
+{
+    static const std::vector<EntityState> emptySnapshot;
+    const std::vector<EntityState> *base = (delta.baseSequence == 0) ? &emptySnapshot : find(delta.baseSequence);
+
+    if (base == nullptr)
+        return nullptr;
+
+    _scratch.clear();
+    _scratch.reserve(base->size() + delta.created.size());
+
+    auto updated = delta.updated.begin();
+    for (const EntityState &entity : *base)
+    {
+        if (std::binary_search(delta.destroyed.begin(), delta.destroyed.end(), entity.entityId))
+            continue;
+
+        _scratch.push_back(entity);
+        // Both lists are sorted by id, the next update can only be for this entity or a later one
+        while (updated != delta.updated.end() && updated->state.entityId < entity.entityId)
+            ++updated;
+        if (updated != delta.updated.end() && updated->state.entityId == entity.entityId)
+            patchEntity(_scratch.back(), *updated);
+    }
+    _scratch.insert(_scratch.end(), delta.created.begin(), delta.created.end());
+    std::sort(_scratch.begin(), _scratch.end(),
+              [](const EntityState &lhs, const EntityState &rhs) { return lhs.entityId < rhs.entityId; });
+
+    // The swap hands the slot's old buffer back to _scratch for the next delta
+    Snapshot &snapshot = _snapshots[delta.sequence % SNAPSHOT_HISTORY_SIZE];
+    snapshot.sequence = delta.sequence;
+    snapshot.entities.swap(_scratch);
+    return &snapshot.entities;
+}
+
+/**
+ * @brief Finds a rebuilt snapshot.
+ *
+ * @param sequence: the snapshot sequence
+ * @return its entities, nullptr for sequence 0 or a snapshot that fell out of the ring
+ */
+const std::vector<EntityState> *SnapshotHistory::find(uint32_t sequence) const
+{
+    const Snapshot &snapshot = _snapshots[sequence % SNAPSHOT_HISTORY_SIZE];
+
+    if (sequence == 0 || snapshot.sequence != sequence)
+        return nullptr;
+    return &snapshot.entities;
+}
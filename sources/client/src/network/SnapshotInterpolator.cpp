@@ -0,0 +1,161 @@
+#include "network/SnapshotInterpolator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace client;
+
+SnapshotInterpolator::SnapshotInterpolator(std::chrono::milliseconds delay) : _delay(delay), _snapshots() {}
+
+SnapshotInterpolator::~SnapshotInterpolator() {}
+
+/**
+ * @brief Sets how far in the past the entities are shown.
+ *
+ * A longer delay hides longer gaps between snapshots, at the cost of seeing the other entities later.
+ * @param delay: a little more than the interval between two snapshots
+ */
+void SnapshotInterpolator::setDelay(std::chrono::milliseconds delay)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _delay = delay;
+}
+
+std::chrono::milliseconds SnapshotInterpolator::getDelay() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _delay;
+}
+
+/**
+ * @brief Stores a snapshot, the oldest one is dropped once the buffer is full.
+ *
+ * @param entities: every entity of the snapshot
+ * @param received: when it arrived. Snapshots that arrive bunched up are shown at the average interval instead, so
+ * an entity doesn't rush between them (never later than half the delay after their arrival).
+ */
+void SnapshotInterpolator::push(const std::vector<EntityState> &entities, Clock::time_point received)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Clock::time_point time = received;
+
+    if (_count > 0)
+    {
+        const Snapshot &newest = _at(_count - 1);
+
+        _interval = (_count > 1) ? (_interval * 7 + (received - newest.received)) / 8 : received - newest.received;
+        time = std::max(received, std::min(newest.time + _interval, received + _delay / 2));
+    }
+
+    if (_count == INTERPOLATION_SNAPSHOTS)
+    {
+        _first = (_first + 1) % INTERPOLATION_SNAPSHOTS;
+        --_count;
+    }
+
+    Snapshot &snapshot = _snapshots[(_first + _count++) % INTERPOLATION_SNAPSHOTS];
+    snapshot.received = received;
+    snapshot.time = time;
+    snapshot.entities.assign(entities.begin(), entities.end());
+    std::sort(snapshot.entities.begin(), snapshot.entities.end(),
+              [](const EntityState &a, const EntityState &b) { return a.entityId < b.entityId; });
+}
+
+/**
+ * @brief Drops every snapshot, e.g. when a new game starts.
+ */
+void SnapshotInterpolator::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _first = 0;
+    _count = 0;
+    _interval = Clock::duration::zero();
+}
+
+/**
+ * @brief The entities as they were at now - delay.
+ *
+ * Between two snapshots, the positions are blended, the other fields come from the newer one. Entities missing from
+ * the older snapshot, replaced or that wrapped around the world are taken as they are in the newer one.
+ *
+ * @param now: the render time
+ * @return the entities, sorted by id, valid until the next call
+ */
+const std::vector<EntityState> &SnapshotInterpolator::sample(Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Clock::time_point renderTime = now - _delay;
+
+    _sampled.clear();
+    if (_count == 0)
+    {
+        return _sampled;
+    }
+
+    // Past the newest snapshot: extrapolated on the velocities, for a while
+    const Snapshot &newest = _at(_count - 1);
+    if (renderTime >= newest.time)
+    {
+        Clock::duration ahead = std::min<Clock::duration>(renderTime - newest.time,
+                                                          std::chrono::milliseconds(MAX_EXTRAPOLATION_MS));
+        float seconds = std::chrono::duration<float>(ahead).count();
+
+        _sampled.assign(newest.entities.begin(), newest.entities.end());
+        for (auto &entity : _sampled)
+        {
+            entity.posX += entity.velX * seconds;
+            entity.posY += entity.velY * seconds;
+        }
+        return _sampled;
+    }
+
+    // Before the oldest one, nothing to blend with
+    size_t next = 0;
+    while (_at(next).time <= renderTime)
+    {
+        ++next;
+    }
+    if (next == 0)
+    {
+        _sampled.assign(_at(0).entities.begin(), _at(0).entities.end());
+        return _sampled;
+    }
+
+    const Snapshot &from = _at(next - 1);
+    const Snapshot &to = _at(next);
+    float t = std::chrono::duration<float>(renderTime - from.time).count() /
+              std::chrono::duration<float>(to.time - from.time).count();
+    auto previous = from.entities.begin();
+
+    _sampled.assign(to.entities.begin(), to.entities.end());
+    for (auto &entity : _sampled)
+    {
+        while (previous != from.entities.end() && previous->entityId < entity.entityId)
+        {
+            ++previous;
+        }
+        if (previous == from.entities.end() || previous->entityId != entity.entityId ||
+            previous->entityType != entity.entityType)
+        {
+            continue;
+        }
+
+        float dx = entity.posX - previous->posX;
+        float dy = entity.posY - previous->posY;
+        if (std::abs(dx) > INTERPOLATION_SNAP_DISTANCE || std::abs(dy) > INTERPOLATION_SNAP_DISTANCE)
+        {
+            continue;
+        }
+        entity.posX = previous->posX + dx * t;
+        entity.posY = previous->posY + dy * t;
+    }
+    return _sampled;
+}
+
+const SnapshotInterpolator::Snapshot &SnapshotInterpolator::_at(size_t index) const
+{
+    return _snapshots[(_first + index) % INTERPOLATION_SNAPSHOTS];
+}
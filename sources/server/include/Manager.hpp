@@ -4,28 +4,49 @@
 #include "Entity.hpp"    // Include your Entity type
 #include "Protocol.hpp"  // For the message types
 #include "Registry.hpp"  // Include your Registry header
+#include "SpscRing.hpp"
 
 #include <asio.hpp>
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <functional>
 #include <mutex>
-#include <queue>
 #include <unordered_map>
 
+// Ring capacities (powers of two), pushes beyond them are dropped and counted
+#define INPUT_RING_CAPACITY 1024
+#define STATE_RING_CAPACITY 8
+
 namespace server
 {
 
 class Manager
 {
   public:
-    // Input handling
-    void pushInput(const UserInputMessage &msg);
+    // Called from the ECS thread each time there is something new for the network layer (state update, game over)
+    using OutputCallback = std::function<void()>;
+
+    // Input handling, pushed by the network thread and popped by the ECS thread
+    bool pushInput(const UserInputMessage &msg);
     bool popInput(UserInputMessage &msg);
 
-    // State update handling
-    void pushStateUpdate(const StateUpdateMessage &msg);
+    // State update handling, pushed by the ECS thread and popped by the network thread
+    // fill(StateUpdateMessage &) builds the update in place, in a slot that still holds an old update's buffers
+    template <typename Function> bool pushStateUpdate(Function &&fill);
+    // msg receives the update, the slot gets msg's previous content back to be reused
     bool popStateUpdate(StateUpdateMessage &msg);
 
+    // Must be set before the ECS thread starts
+    void setOutputCallback(OutputCallback callback);
+
+    // Number of messages dropped because a ring was full
+    uint64_t inputOverflows() const;
+    uint64_t stateOverflows() const;
+    // Input commands dropped because a player was over its budget, counted by the ECS thread
+    void countDroppedCommands(uint64_t count);
+    uint64_t droppedCommands() const;
+
     // Client handling
     void addClient(uint32_t clientId, const asio::ip::udp::endpoint &endpoint);
     void removeClient(uint32_t clientId);
@@ -38,8 +59,9 @@ class Manager
     // Entity <-> Client mapping
     void mapClientToEntity(uint32_t clientId, Entity entity);
     bool hasEntityForClient(uint32_t clientId);
-    Entity getEntityForClient(uint32_t clientId);
-    uint32_t getClientIdForEntityId(size_t entityId);
+    Entity getEntityForClient(uint32_t clientId);  // An invalid Entity if the client has none
+    // NO_CLIENT_ID unless entity is the player of a client, a recycled id doesn't match its dead player's handle
+    uint32_t getClientIdForEntity(Entity entity);
 
     std::pair<bool, GameOverType> getGameOverStatus();
 
@@ -47,15 +69,13 @@ class Manager
     void setGameOverStatus(bool isOver, GameOverType type);
 
   private:
-    // Input queue
-    std::queue<UserInputMessage> _inputQueue;
-    std::mutex _inputMutex;
-    std::condition_variable _inputCV;
+    // Input ring
+    SpscRing<UserInputMessage, INPUT_RING_CAPACITY> _inputRing;
 
-    // State queue
-    std::queue<StateUpdateMessage> _stateQueue;
-    std::mutex _stateMutex;
-    std::condition_variable _stateCV;
+    // State ring
+    SpscRing<StateUpdateMessage, STATE_RING_CAPACITY> _stateRing;
+    OutputCallback _outputCallback;
+    std::atomic<uint64_t> _droppedCommands {0};
 
     // Connected clients
     std::unordered_map<uint32_t, asio::ip::udp::endpoint> _clients;
@@ -69,8 +89,8 @@ class Manager
     std::unordered_map<uint32_t, Entity> _clientToEntityMap;
 
     std::mutex _entityMapMutex;
-    // new entity id to clinet
-    std::unordered_map<size_t, uint32_t> _entityIdToClientId;
+    // Player entity id to client, with the player's handle: the id outlives the player once recycled
+    std::unordered_map<size_t, std::pair<Entity, uint32_t>> _entityIdToClientId;
     std::mutex _clientIdMapMutex;
 
     std::mutex _gameOverMutex;
@@ -78,6 +98,16 @@ class Manager
     GameOverType _gameOverType {GameOverType::None};  // Default or pick whichever
 };
 
+template <typename Function> bool Manager::pushStateUpdate(Function &&fill)
+{
+    bool pushed = _stateRing.push_with(std::forward<Function>(fill));
+
+    // Even when the ring is full, make sure the network layer drains it
+    if (_outputCallback)
+        _outputCallback();
+    return pushed;
+}
+
 }  // namespace server
 
 #endif  // MANAGER_HPP
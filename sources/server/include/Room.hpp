@@ -0,0 +1,60 @@
+#ifndef ROOM_HPP
+#define ROOM_HPP
+
+#include "Manager.hpp"
+#include "SceneManager.hpp"
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Players in a match, the lobby stops taking new ones once full
+#define MAX_PLAYERS_PER_ROOM 4
+
+namespace server
+{
+
+// One match: its own Manager (registry, client set, rings) and scenes, from the lobby to the game over.
+// tick() runs on the game loop workers, one at a time for a given room.
+class Room
+{
+  public:
+    // pool runs the systems of the match concurrently, see Registry::run_systems (nullptr: on the ticking thread)
+    Room(uint32_t id, ThreadPool *pool = nullptr);
+    ~Room();
+    Room(Room const &) = delete;
+    Room &operator=(Room const &) = delete;
+
+    // Runs one tick of the current scene, returns false once the match is over
+    bool tick(float dt);
+
+    uint32_t id() const;
+    Manager &getManager();
+
+    // Safe from any thread
+    bool inLobby() const;  // Players may still join
+    bool isOver() const;
+    std::chrono::steady_clock::time_point overSince() const;  // Only meaningful once isOver()
+
+  private:
+    // Sets the game over status in the manager when the match is won or lost
+    bool checkGameOver();
+
+  private:
+    uint32_t _id;
+    Manager _manager;
+    SceneManager _sceneManager;
+
+    size_t _sceneIdx;
+    std::chrono::time_point<std::chrono::high_resolution_clock> _sceneStartTime;
+
+    std::atomic<bool> _inLobby {true};
+    std::atomic<bool> _over {false};
+    std::atomic<std::chrono::steady_clock::rep> _overSince {0};
+};
+
+}  // namespace server
+
+#endif  // ROOM_HPP
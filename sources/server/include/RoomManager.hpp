@@ -0,0 +1,77 @@
+#ifndef ROOM_MANAGER_HPP
+#define ROOM_MANAGER_HPP
+
+#include "Room.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Matches hosted at the same time by the process
+#define MAX_ROOMS 64
+// How long a finished match stays open (its game over keeps being sent) before its room is closed
+#define ROOM_CLOSE_DELAY_MS 10000
+
+namespace server
+{
+
+// Rooms hosted by the server and the room each client is seated in.
+// join/leave/find are called by the network thread, rooms/closeRooms by the game loop.
+class RoomManager
+{
+  public:
+    using RoomCallback = std::function<void(const std::shared_ptr<Room> &room)>;
+
+  public:
+    // pool is given to every room to run its systems, it must outlive the room manager
+    RoomManager(ThreadPool *pool = nullptr, size_t maxRooms = MAX_ROOMS);
+    ~RoomManager();
+
+    // Seats the client in its current room, else in a room still in the lobby with a free seat, else in a new room.
+    // nullptr when no room can take it
+    std::shared_ptr<Room> join(uint32_t clientId);
+    // Frees the client's seat, returns the room it was in (nullptr if it had none)
+    std::shared_ptr<Room> leave(uint32_t clientId);
+    std::shared_ptr<Room> find(uint32_t clientId) const;
+
+    // Copies the open rooms into rooms
+    void rooms(std::vector<std::shared_ptr<Room>> &rooms) const;
+    // Closes the rooms nobody is seated in and the finished ones past ROOM_CLOSE_DELAY_MS, returns how many
+    size_t closeRooms();
+    size_t roomCount() const;
+
+    // Must be set before the first join.
+    // opened is called by join under the room manager lock, before the game loop can see the room.
+    // closed is called by closeRooms once the room won't be ticked anymore.
+    void setRoomOpenedCallback(RoomCallback callback);
+    void setRoomClosedCallback(RoomCallback callback);
+
+  private:
+    struct Seats
+    {
+        std::shared_ptr<Room> room;
+        size_t clients = 0;
+    };
+
+    // Frees the client's seat, _mutex must be held
+    std::shared_ptr<Room> unseat(uint32_t clientId);
+
+  private:
+    mutable std::mutex _mutex;
+    std::vector<Seats> _rooms;
+    std::unordered_map<uint32_t, std::shared_ptr<Room>> _clientRooms;  // clientId -> room
+    ThreadPool *_pool;
+    size_t _maxRooms;
+    uint32_t _nextRoomId;
+
+    RoomCallback _roomOpenedCallback;
+    RoomCallback _roomClosedCallback;
+};
+
+}  // namespace server
+
+#endif  // ROOM_MANAGER_HPP
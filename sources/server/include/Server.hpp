@@ -1,19 +1,24 @@
 #ifndef SERVER_HPP
 #define SERVER_HPP
 
+#define DEFAULT_TICK_RATE 60
+
 namespace server
 {
 
 class Server
 {
   public:
-    Server(unsigned short port);
+    // workerThreads 0 picks one less than the hardware threads (the game loop thread ticks rooms too)
+    Server(unsigned short port, unsigned int tickRate = DEFAULT_TICK_RATE, unsigned int workerThreads = 0);
     ~Server();
 
     void run();
 
   private:
     unsigned short _port;
+    unsigned int _tickRate;       // simulation ticks per second
+    unsigned int _workerThreads;  // threads ticking rooms besides the game loop thread
 };
 
 }  // namespace server
@@ -0,0 +1,112 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace server
+{
+
+// Bounded lock-free single producer / single consumer queue.
+// Every slot is allocated up front and never destroyed while the ring lives: a slot is filled in place (push_with) or
+// assigned (push), and pop() swaps it with the caller's value, so heap buffers owned by T (e.g. a std::vector) keep
+// circulating between the two threads instead of being reallocated for every message.
+// Exactly one thread may push and exactly one thread may pop.
+template <typename T, size_t Capacity> class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+  public:
+    SpscRing() = default;
+    SpscRing(SpscRing const &) = delete;
+    SpscRing &operator=(SpscRing const &) = delete;
+
+    // Producer side, returns false and counts an overflow when the ring is full
+    bool push(T const &value);
+    bool push(T &&value);
+    // fill(T &slot) writes the message directly into its slot
+    template <typename Function> bool push_with(Function &&fill);
+
+    // Consumer side, returns false when the ring is empty
+    bool pop(T &out);
+
+    size_t size() const;  // approximate when called from a third thread
+    bool empty() const;
+    static constexpr size_t capacity() { return Capacity; }
+    uint64_t overflows() const;  // number of rejected pushes
+
+  private:
+    static constexpr size_t _mask = Capacity - 1;
+    static constexpr size_t _cacheLine = 64;
+
+    // Keeps the producer and consumer indexes on separate cache lines
+    alignas(_cacheLine) std::atomic<size_t> _head {0};  // next slot to pop, written by the consumer
+    alignas(_cacheLine) std::atomic<size_t> _tail {0};  // next slot to push, written by the producer
+    alignas(_cacheLine) std::atomic<uint64_t> _overflows {0};
+    std::array<T, Capacity> _slots {};
+};
+
+template <typename T, size_t Capacity> bool SpscRing<T, Capacity>::push(T const &value)
+{
+    return push_with([&value](T &slot) { slot = value; });
+}
+
+template <typename T, size_t Capacity> bool SpscRing<T, Capacity>::push(T &&value)
+{
+    return push_with([&value](T &slot) { slot = std::move(value); });
+}
+
+template <typename T, size_t Capacity>
+template <typename Function>
+bool SpscRing<T, Capacity>::push_with(Function &&fill)
+{
+    size_t tail = _tail.load(std::memory_order_relaxed);
+
+    if (tail - _head.load(std::memory_order_acquire) == Capacity)
+    {
+        _overflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    fill(_slots[tail & _mask]);
+    // Publishes the slot content to the consumer
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t Capacity> bool SpscRing<T, Capacity>::pop(T &out)
+{
+    size_t head = _head.load(std::memory_order_relaxed);
+
+    if (head == _tail.load(std::memory_order_acquire))
+        return false;
+
+    using std::swap;
+    swap(out, _slots[head & _mask]);
+    // Hands the slot (now holding out's previous content) back to the producer
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t Capacity> size_t SpscRing<T, Capacity>::size() const
+{
+    // head first: tail only grows, so it can't be read behind it
+    size_t head = _head.load(std::memory_order_acquire);
+    return _tail.load(std::memory_order_acquire) - head;
+}
+
+template <typename T, size_t Capacity> bool SpscRing<T, Capacity>::empty() const
+{
+    return size() == 0;
+}
+
+template <typename T, size_t Capacity> uint64_t SpscRing<T, Capacity>::overflows() const
+{
+    return _overflows.load(std::memory_order_relaxed);
+}
+
+}  // namespace server
+
+#endif  // SPSC_RING_HPP
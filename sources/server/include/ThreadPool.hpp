@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace server
+{
+
+// Fixed set of worker threads running batches of independent tasks. The thread calling run() works on the batch too
+// and only returns once every task of the batch returned, so tasks may use whatever the caller owns.
+// run() may be called from several threads at once and from inside a task (e.g. a room tick running its systems):
+// idle workers pick tasks from the oldest batch with some left, while each caller keeps picking tasks of its own
+// batch, so a batch always completes even when every worker is busy.
+class ThreadPool
+{
+  public:
+    using Task = std::function<void(size_t index)>;
+
+  public:
+    // workers threads besides the callers, 0 runs everything on the caller
+    ThreadPool(size_t workers);
+    ~ThreadPool();
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool &operator=(ThreadPool const &) = delete;
+
+    // Calls task(0) .. task(count - 1), spread over the workers and the calling thread
+    void run(size_t count, const Task &task);
+
+    size_t threads() const;  // workers + the calling thread
+
+  private:
+    struct Batch
+    {
+        const Task *task;
+        size_t count;
+        size_t next;       // Next task index to pick
+        size_t remaining;  // Tasks not finished yet
+        std::condition_variable done;
+    };
+
+    void workerLoop();
+    // Picks the next task of the batch and runs it, _mutex is released while the task runs
+    void runOne(std::unique_lock<std::mutex> &lock, Batch &batch);
+
+  private:
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wake;  // Workers wait for a batch with tasks left to pick
+    std::deque<Batch *> _batches;   // Batches with tasks left to pick, oldest first
+    bool _stopping = false;
+};
+
+}  // namespace server
+
+#endif  // THREAD_POOL_HPP
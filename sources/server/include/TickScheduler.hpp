@@ -0,0 +1,56 @@
+#ifndef TICK_SCHEDULER_HPP
+#define TICK_SCHEDULER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+namespace server
+{
+
+// Fixed timestep loop: ticks are scheduled on absolute deadlines (start + n * period), so the time spent simulating
+// doesn't add up to the tick length. When late, up to maxCatchUpTicks ticks are run back to back, anything beyond
+// that is dropped so the simulation stays at a consistent rate instead of running in slow motion.
+class TickScheduler
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // Returns false to stop the loop, dt is always the fixed tick length in seconds
+    using TickFunction = std::function<bool(float dt)>;
+
+    struct Stats
+    {
+        uint64_t ticks = 0;         // ticks run
+        uint64_t catchUpTicks = 0;  // ticks run back to back because the loop was late
+        uint64_t droppedTicks = 0;  // ticks skipped because the catch up cap was reached
+        uint64_t overruns = 0;      // ticks that took longer than the tick period
+        clock::duration worstTick = clock::duration::zero();
+    };
+
+  public:
+    TickScheduler(unsigned int tickRate, unsigned int maxCatchUpTicks = 5);
+    ~TickScheduler();
+
+    // Blocks, calling tick at the scheduler rate until it returns false
+    void run(const TickFunction &tick);
+
+    unsigned int tickRate() const;
+    float dt() const;
+    clock::duration period() const;
+    const Stats &stats() const;
+
+  private:
+    unsigned int _tickRate;
+    unsigned int _maxCatchUpTicks;
+    clock::duration _period;
+    float _dt;
+    Stats _stats;
+};
+
+std::ostream &operator<<(std::ostream &os, const TickScheduler::Stats &stats);
+
+}  // namespace server
+
+#endif  // TICK_SCHEDULER_HPP
@@ -0,0 +1,73 @@
+#ifndef COMMAND_BUFFER_HPP
+#define COMMAND_BUFFER_HPP
+
+#include "Entity.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace server
+{
+
+class Registry;
+
+// Structural changes (spawn, kill, add/remove component) recorded while the component arrays are being iterated,
+// applied by Registry::flush_commands() at the end of run_systems, once nothing iterates them anymore.
+// The flush applies them one component array at a time: spawns, added components, removed components, then kills.
+// Commands aimed at an entity that is dead by the time they are applied are dropped.
+class CommandBuffer
+{
+  public:
+    CommandBuffer(Registry &registry);
+    ~CommandBuffer() = default;
+    CommandBuffer(CommandBuffer const &) = delete;
+    CommandBuffer &operator=(CommandBuffer const &) = delete;
+
+    // The id is reserved right away so components can be recorded for it, the entity is alive after the flush
+    Entity spawn_entity();
+    void kill_entity(const Entity &entity);
+
+    template <typename Component> void add_component(const Entity &entity, Component &&component);
+    template <typename Component> void remove_component(const Entity &entity);
+
+    // Room for count entities spawned with the components in one flush, the buffers keep it from then on
+    template <typename... Components> void reserve(size_t count);
+
+    bool empty() const;
+
+  private:
+    // Commands of one component type, the type is only known by the derived class
+    struct PendingComponents
+    {
+        virtual ~PendingComponents() = default;
+        virtual void apply(Registry &registry) = 0;  // Adds, then removes, then clears (keeping the capacity)
+        virtual bool empty() const = 0;
+    };
+
+    template <typename Component> struct Pending : PendingComponents
+    {
+        void apply(Registry &registry) override;
+        bool empty() const override { return added.empty() && removed.empty(); }
+
+        std::vector<std::pair<Entity, Component>> added;
+        std::vector<Entity> removed;
+    };
+
+    template <typename Component> Pending<Component> &pending();
+
+  private:
+    friend class Registry;
+
+    Registry &_registry;
+    std::vector<Entity> _spawned;
+    std::vector<Entity> _killed;
+    std::vector<std::unique_ptr<PendingComponents>> _components;  // Indexed by ComponentId
+};
+
+// The member templates need the complete Registry, they are defined at the end of Registry.hpp
+
+}  // namespace server
+
+#endif  // COMMAND_BUFFER_HPP
@@ -0,0 +1,27 @@
+#ifndef COMPONENT_ID_HPP
+#define COMPONENT_ID_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace server
+{
+
+// Dense index of each component type, used to index the registries' flat tables (see Registry::get_components).
+// A type gets the next free index the first time it is asked for, the same one in every registry of the process.
+class ComponentId
+{
+  public:
+    template <typename Component> static size_t get()
+    {
+        static const size_t id = _next.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+  private:
+    static inline std::atomic<size_t> _next {0};
+};
+
+}  // namespace server
+
+#endif  // COMPONENT_ID_HPP
@@ -2,22 +2,28 @@
 #define ENTITY_HPP
 
 #include <cstddef>
+#include <cstdint>
 
 namespace server
 {
 
 class Registry;
 
+// Handle to an entity: the index of its components plus the generation of that index when it was spawned.
+// Indexes are recycled, the generation tells a stale handle from the entity now living at the same index.
 class Entity
 {
   public:
-    Entity() : _id(static_cast<size_t>(-1)) {}
-    explicit Entity(size_t id) : _id(id) {}
+    Entity() : _id(static_cast<size_t>(-1)), _generation(0) {}
+    explicit Entity(size_t id, uint32_t generation = 0) : _id(id), _generation(generation) {}
 
     // Implicit conversion to size_t for component array indexing
     operator size_t() const { return _id; }
 
+    uint32_t generation() const { return _generation; }
+
     size_t _id;
+    uint32_t _generation;
 
     // Allow registry to create and manage entities
     friend class Registry;
@@ -4,15 +4,18 @@
 #include "IndexedZipperIterator.hpp"
 
 #include <algorithm>
+#include <iterator>
 
 namespace server
 {
 
+// Iterates the entities owning a component in every container, yielding (id, components...)
+// The smallest container drives the iteration so the others are only probed for the ids it holds
 template <typename... Containers> class IndexedZipper
 {
   public:
     using iterator = IndexedZipperIterator<Containers...>;
-    using iterator_tuple = typename iterator::iterator_tuple;
+    using container_tuple = typename iterator::container_tuple;
 
   public:
     IndexedZipper(Containers &...cs);
@@ -20,43 +23,44 @@ template <typename... Containers> class IndexedZipper
     iterator begin();
     iterator end();
 
+    // Upper bound of the number of entities yielded (size of the pivot container)
+    size_t size_hint() const;
+
   private:
-    // Computes maximum index of our iterators.
-    static size_t _compute_size(Containers &...containers);
-    // Computes an iterator_tuple that will allow us to build our end iterator.
-    static iterator_tuple _compute_end(Containers &...containers);
+    // Computes the index of the container holding the fewest entries.
+    static size_t _compute_pivot(Containers &...containers);
 
   private:
-    iterator_tuple _begin;
-    iterator_tuple _end;
+    container_tuple _containers;
+    size_t _pivot;
     size_t _size;
 };
 
 template <typename... Containers>
 IndexedZipper<Containers...>::IndexedZipper(Containers &...cs)
-    : _begin(std::make_tuple(cs.begin()...)), _end(_compute_end(cs...)), _size(_compute_size(cs...))
+    : _containers(std::make_tuple(&cs...)), _pivot(_compute_pivot(cs...)), _size(std::min({cs.size()...}))
 {}
 
 template <typename... Containers> typename IndexedZipper<Containers...>::iterator IndexedZipper<Containers...>::begin()
 {
-    return IndexedZipperIterator<Containers...>(_begin, _size);
+    return IndexedZipperIterator<Containers...>(_containers, _pivot, 0, _size);
 }
 
 template <typename... Containers> typename IndexedZipper<Containers...>::iterator IndexedZipper<Containers...>::end()
 {
-    return IndexedZipperIterator<Containers...>(_end, _size);
+    return IndexedZipperIterator<Containers...>(_containers, _pivot, _size, _size);
 }
 
-template <typename... Containers> size_t IndexedZipper<Containers...>::_compute_size(Containers &...containers)
+template <typename... Containers> size_t IndexedZipper<Containers...>::size_hint() const
 {
-    return std::min({containers.size()...});
+    return _size;
 }
 
-template <typename... Containers>
-typename IndexedZipper<Containers...>::iterator_tuple IndexedZipper<Containers...>::_compute_end(
-    Containers &...containers)
+template <typename... Containers> size_t IndexedZipper<Containers...>::_compute_pivot(Containers &...containers)
 {
-    return std::make_tuple((containers.begin() + _compute_size(containers...))...);
+    const size_t sizes[] = {containers.size()...};
+
+    return static_cast<size_t>(std::distance(std::begin(sizes), std::min_element(std::begin(sizes), std::end(sizes))));
 }
 
 }  // namespace server
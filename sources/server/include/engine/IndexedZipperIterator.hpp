@@ -1,38 +1,44 @@
 #ifndef INDEXED_ZIPPER_ITERATOR_HPP
 #define INDEXED_ZIPPER_ITERATOR_HPP
 
+#include <cstddef>
 #include <iterator>
+#include <tuple>
+#include <utility>
 
 namespace server
 {
 
 template <typename... Containers> class IndexedZipper;
 
+// Walks the entity ids of the pivot container (the smallest one) and only stops on ids owned by every container.
+// Containers must provide size(), id_at(n) and find(id) (see SparseArray and PackedArray).
 template <typename... Containers> class IndexedZipperIterator
 {
-    // type of Container::begin() return value
-    template <typename Container> using iterator_t = decltype(std::declval<Container>().begin());
+    // type of Container::find() return value
+    template <typename Container> using pointer_t = decltype(std::declval<Container &>().find(size_t {}));
 
-    template <typename Container> using it_reference_t = typename iterator_t<Container>::reference;
+    template <typename Container> using it_reference_t = decltype(*std::declval<pointer_t<Container>>());
 
   public:
-    // std::tuple of references to components
+    // std::tuple of the entity id followed by references to components
     using value_type = std::tuple<size_t, it_reference_t<Containers>...>;
     using reference = value_type;
     using pointer = void;
     using difference_type = std::ptrdiff_t;
     using iterator_category = std::forward_iterator_tag;
-    using iterator_tuple = std::tuple<iterator_t<Containers>...>;
+    using container_tuple = std::tuple<Containers *...>;
+    using pointer_tuple = std::tuple<pointer_t<Containers>...>;
 
     // If we want zipper_iterator to be built by zipper only
     friend IndexedZipper<Containers...>;
 
   public:
-    IndexedZipperIterator(IndexedZipperIterator const &z);
-    IndexedZipperIterator(iterator_tuple const &it_tuple, size_t max);
+    IndexedZipperIterator(IndexedZipperIterator const &z) = default;
+    IndexedZipperIterator(container_tuple const &containers, size_t pivot, size_t pos, size_t max);
 
-    IndexedZipperIterator operator++();
-    IndexedZipperIterator &operator++(int);
+    IndexedZipperIterator &operator++();
+    IndexedZipperIterator operator++(int);
 
     value_type operator*();
     value_type operator->();
@@ -44,52 +50,43 @@ template <typename... Containers> class IndexedZipperIterator
     friend bool operator!=(IndexedZipperIterator<Cs...> const &lhs, IndexedZipperIterator<Cs...> const &rhs);
 
   private:
-    // Increment every iterator at the same time. It also skips to the next value if one of the pointed to std::optional does not contains a value
-    template <size_t... Is> void incr_all(std::index_sequence<Is...>);
-    // check if every std::optional are set
-    template <size_t... Is> bool all_set(std::index_sequence<Is...>);
+    // Moves forward until every container owns the entity at the pivot position (or the end is reached)
+    void skip_unset();
+    // entity id stored at _pos in the pivot container
+    template <size_t... Is> size_t pivot_id(std::index_sequence<Is...>) const;
+    // look the entity up in every container, false if one of them does not own it
+    template <size_t... Is> bool fetch_all(std::index_sequence<Is...>);
     // return a tuple of reference to components
     template <size_t... Is> value_type to_value(std::index_sequence<Is...>);
 
   private:
-    iterator_tuple _current;
-    size_t _max;  // compare this value to _idx to prevent infinite loop
-    size_t _idx;  // current index
+    container_tuple _containers;
+    pointer_tuple _current;  // components of the current entity, valid while _pos < _max
+    size_t _pivot;           // index of the container driving the iteration
+    size_t _pos;             // current position in the pivot container
+    size_t _max;             // size of the pivot container
+    size_t _id;              // current entity id
     static constexpr std::index_sequence_for<Containers...> _seq {};
 };
 
 template <typename... Containers>
-IndexedZipperIterator<Containers...>::IndexedZipperIterator(IndexedZipperIterator const &z)
-    : _current(z._current), _max(z._max), _idx(z._idx)
+IndexedZipperIterator<Containers...>::IndexedZipperIterator(container_tuple const &containers, size_t pivot,
+                                                            size_t pos, size_t max)
+    : _containers(containers), _current(), _pivot(pivot), _pos(pos), _max(max), _id(0)
 {
-    throw std::logic_error("IndexedZipperIterator is unstable, restrain from using it (out of bounds read)");
+    skip_unset();
 }
 
 template <typename... Containers>
-IndexedZipperIterator<Containers...>::IndexedZipperIterator(iterator_tuple const &it_tuple, size_t max)
-    : _current(it_tuple), _max(max), _idx(0)
+IndexedZipperIterator<Containers...> &IndexedZipperIterator<Containers...>::operator++()
 {
-    if (!all_set(_seq))
-    {
-        ++(*this);
-    }
-}
-
-template <typename... Containers>
-IndexedZipperIterator<Containers...> IndexedZipperIterator<Containers...>::operator++()
-{
-    ++_idx;
-    incr_all(_seq);
-    while (_idx < _max && !all_set(_seq))
-    {
-        ++_idx;
-        incr_all(_seq);
-    }
+    ++_pos;
+    skip_unset();
     return *this;
 }
 
 template <typename... Containers>
-IndexedZipperIterator<Containers...> &IndexedZipperIterator<Containers...>::operator++(int)
+IndexedZipperIterator<Containers...> IndexedZipperIterator<Containers...>::operator++(int)
 {
     IndexedZipperIterator temp = *this;
     ++(*this);
@@ -111,27 +108,41 @@ typename IndexedZipperIterator<Containers...>::value_type IndexedZipperIterator<
 template <typename... Containers>
 bool operator==(IndexedZipperIterator<Containers...> const &lhs, IndexedZipperIterator<Containers...> const &rhs)
 {
-    return lhs._idx == rhs._idx;
+    return lhs._pos == rhs._pos;
 }
 
 template <typename... Containers>
 bool operator!=(IndexedZipperIterator<Containers...> const &lhs, IndexedZipperIterator<Containers...> const &rhs)
 {
-    return lhs._idx != rhs._idx;
+    return lhs._pos != rhs._pos;
+}
+
+template <typename... Containers> void IndexedZipperIterator<Containers...>::skip_unset()
+{
+    while (_pos < _max)
+    {
+        _id = pivot_id(_seq);
+        if (fetch_all(_seq))
+            return;
+        ++_pos;
+    }
 }
 
 template <typename... Containers>
 template <size_t... Is>
-void IndexedZipperIterator<Containers...>::incr_all(std::index_sequence<Is...>)
+size_t IndexedZipperIterator<Containers...>::pivot_id(std::index_sequence<Is...>) const
 {
-    (++std::get<Is>(_current), ...);
+    size_t id = 0;
+
+    ((Is == _pivot ? (id = std::get<Is>(_containers)->id_at(_pos), true) : false) || ...);
+    return id;
 }
 
 template <typename... Containers>
 template <size_t... Is>
-bool IndexedZipperIterator<Containers...>::all_set(std::index_sequence<Is...>)
+bool IndexedZipperIterator<Containers...>::fetch_all(std::index_sequence<Is...>)
 {
-    return (std::get<Is>(_current)->has_value() && ...);
+    return ((std::get<Is>(_current) = std::get<Is>(_containers)->find(_id)) && ...);
 }
 
 template <typename... Containers>
@@ -139,8 +150,8 @@ template <size_t... Is>
 typename IndexedZipperIterator<Containers...>::value_type IndexedZipperIterator<Containers...>::to_value(
     std::index_sequence<Is...>)
 {
-    // Return a tuple that starts with the current index, followed by component values (tie -> tuple of references)
-    return std::tie(_idx, (*std::get<Is>(_current))...);
+    // Return a tuple that starts with the current entity id, followed by references to the components
+    return value_type(_id, (*std::get<Is>(_current))...);
 }
 
 }  // namespace server
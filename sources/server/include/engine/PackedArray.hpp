@@ -0,0 +1,362 @@
+#ifndef PACKED_ARRAY_HPP
+#define PACKED_ARRAY_HPP
+
+#include "ComponentName.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace server
+{
+
+// Sparse set storage: live components are packed contiguously in _dense, _entities[n] is the entity owning
+// _dense[n] and _sparse maps an entity id back to its dense slot. Iterating only ever touches live components.
+template <typename Component> class PackedArray
+{
+  public:
+    using value_type = Component;
+    using reference_type = value_type &;
+    using const_reference_type = value_type const &;
+    using container_t = std::vector<value_type>;
+    using size_type = typename container_t::size_type;
+    using iterator = typename container_t::iterator;
+    using const_iterator = typename container_t::const_iterator;
+
+    // Marks an entity id that has no slot in the dense array
+    static constexpr size_type npos = std::numeric_limits<size_type>::max();
+
+  public:
+    // Constructors and Destructor
+    PackedArray();
+    PackedArray(PackedArray const &);      // copy constructor
+    PackedArray(PackedArray &&) noexcept;  // move constructor
+    ~PackedArray();
+
+    // Assignment Operators
+    PackedArray &operator=(PackedArray const &);      // copy assignment operator
+    PackedArray &operator=(PackedArray &&) noexcept;  // move assignment operator
+
+    // Element Access by entity id (the entity MUST own the component, see contains/find)
+    reference_type operator[](size_t id);
+    const_reference_type operator[](size_t id) const;
+
+    // Element Access by entity id, nullptr when the entity does not own the component
+    value_type *find(size_t id);
+    const value_type *find(size_t id) const;
+    bool contains(size_t id) const;
+
+    // Element Access by dense slot, 0 <= n < size()
+    reference_type value_at(size_type n);
+    const_reference_type value_at(size_type n) const;
+    size_t id_at(size_type n) const;
+    const std::vector<size_t> &entities() const;
+
+    // The dense components, for kernels working on plain arrays (see Registry::group)
+    value_type *data();
+    const value_type *data() const;
+
+    // Iterators (live components only, in dense order)
+    iterator begin();
+    const_iterator begin() const;
+    const_iterator cbegin() const;
+
+    iterator end();
+    const_iterator end() const;
+    const_iterator cend() const;
+
+    // Capacity
+    size_type size() const;  // number of live components
+    bool empty() const;
+    // Room for count components of entities whose ids are below ids, inserting them then doesn't reallocate
+    void reserve(size_type count, size_type ids);
+
+    // Modifiers
+    reference_type insert_at(size_type id, Component const &);
+    reference_type insert_at(size_type id, Component &&);
+
+    template <typename... Params> reference_type emplace_at(size_type id, Params &&...);
+
+    // Swap and pop: the last dense component is moved into the freed slot
+    void erase(size_type id);
+    void clear();
+
+    // Swaps the component of the entity (which must own one) with the one at dense slot n
+    void move_to(size_type id, size_type n);
+
+  private:
+    // Makes sure _sparse can be indexed by id
+    void _grow_sparse(size_type id);
+
+  private:
+    container_t _dense;
+    std::vector<size_t> _entities;
+    std::vector<size_type> _sparse;
+};
+
+// Default Constructor
+template <typename Component> PackedArray<Component>::PackedArray() : _dense(), _entities(), _sparse() {}
+
+// Copy Constructor
+template <typename Component>
+PackedArray<Component>::PackedArray(PackedArray const &other)
+    : _dense(other._dense), _entities(other._entities), _sparse(other._sparse)
+{}
+
+// Move Constructor
+template <typename Component>
+PackedArray<Component>::PackedArray(PackedArray &&other) noexcept
+    : _dense(std::move(other._dense)), _entities(std::move(other._entities)), _sparse(std::move(other._sparse))
+{}
+
+// Destructor
+template <typename Component> PackedArray<Component>::~PackedArray() {}
+
+// Copy Assignment Operator
+template <typename Component> PackedArray<Component> &PackedArray<Component>::operator=(PackedArray const &other)
+{
+    if (this != &other)
+    {
+        _dense = other._dense;
+        _entities = other._entities;
+        _sparse = other._sparse;
+    }
+    return *this;
+}
+
+// Move Assignment Operator
+template <typename Component> PackedArray<Component> &PackedArray<Component>::operator=(PackedArray &&other) noexcept
+{
+    if (this != &other)
+    {
+        _dense = std::move(other._dense);
+        _entities = std::move(other._entities);
+        _sparse = std::move(other._sparse);
+    }
+    return *this;
+}
+
+// Element Access Implementations
+template <typename Component>
+typename PackedArray<Component>::reference_type PackedArray<Component>::operator[](size_t id)
+{
+    return _dense[_sparse[id]];
+}
+
+template <typename Component>
+typename PackedArray<Component>::const_reference_type PackedArray<Component>::operator[](size_t id) const
+{
+    return _dense[_sparse[id]];
+}
+
+template <typename Component> typename PackedArray<Component>::value_type *PackedArray<Component>::find(size_t id)
+{
+    return contains(id) ? &_dense[_sparse[id]] : nullptr;
+}
+
+template <typename Component>
+const typename PackedArray<Component>::value_type *PackedArray<Component>::find(size_t id) const
+{
+    return contains(id) ? &_dense[_sparse[id]] : nullptr;
+}
+
+template <typename Component> bool PackedArray<Component>::contains(size_t id) const
+{
+    return id < _sparse.size() && _sparse[id] != npos;
+}
+
+template <typename Component>
+typename PackedArray<Component>::reference_type PackedArray<Component>::value_at(size_type n)
+{
+    return _dense[n];
+}
+
+template <typename Component>
+typename PackedArray<Component>::const_reference_type PackedArray<Component>::value_at(size_type n) const
+{
+    return _dense[n];
+}
+
+template <typename Component> size_t PackedArray<Component>::id_at(size_type n) const
+{
+    return _entities[n];
+}
+
+template <typename Component> const std::vector<size_t> &PackedArray<Component>::entities() const
+{
+    return _entities;
+}
+
+template <typename Component> typename PackedArray<Component>::value_type *PackedArray<Component>::data()
+{
+    return _dense.data();
+}
+
+template <typename Component> const typename PackedArray<Component>::value_type *PackedArray<Component>::data() const
+{
+    return _dense.data();
+}
+
+// Iterator Implementations
+template <typename Component> typename PackedArray<Component>::iterator PackedArray<Component>::begin()
+{
+    return _dense.begin();
+}
+
+template <typename Component> typename PackedArray<Component>::const_iterator PackedArray<Component>::begin() const
+{
+    return _dense.begin();
+}
+
+template <typename Component> typename PackedArray<Component>::const_iterator PackedArray<Component>::cbegin() const
+{
+    return _dense.cbegin();
+}
+
+template <typename Component> typename PackedArray<Component>::iterator PackedArray<Component>::end()
+{
+    return _dense.end();
+}
+
+template <typename Component> typename PackedArray<Component>::const_iterator PackedArray<Component>::end() const
+{
+    return _dense.end();
+}
+
+template <typename Component> typename PackedArray<Component>::const_iterator PackedArray<Component>::cend() const
+{
+    return _dense.cend();
+}
+
+// Capacity Implementation
+template <typename Component> typename PackedArray<Component>::size_type PackedArray<Component>::size() const
+{
+    return _dense.size();
+}
+
+template <typename Component> bool PackedArray<Component>::empty() const
+{
+    return _dense.empty();
+}
+
+template <typename Component> void PackedArray<Component>::reserve(size_type count, size_type ids)
+{
+    _dense.reserve(count);
+    _entities.reserve(count);
+    _sparse.reserve(ids);
+}
+
+// Modifier Implementations
+template <typename Component>
+typename PackedArray<Component>::reference_type PackedArray<Component>::insert_at(size_type id,
+                                                                                  const Component &component)
+{
+    if (contains(id))
+    {
+        return _dense[_sparse[id]] = component;
+    }
+
+    _grow_sparse(id);
+    _sparse[id] = _dense.size();
+    _entities.push_back(id);
+    return _dense.emplace_back(component);
+}
+
+template <typename Component>
+typename PackedArray<Component>::reference_type PackedArray<Component>::insert_at(size_type id, Component &&component)
+{
+    if (contains(id))
+    {
+        return _dense[_sparse[id]] = std::move(component);
+    }
+
+    _grow_sparse(id);
+    _sparse[id] = _dense.size();
+    _entities.push_back(id);
+    return _dense.emplace_back(std::move(component));
+}
+
+template <typename Component>
+template <typename... Params>
+typename PackedArray<Component>::reference_type PackedArray<Component>::emplace_at(size_type id, Params &&...params)
+{
+    if (contains(id))
+    {
+        return _dense[_sparse[id]] = Component(std::forward<Params>(params)...);
+    }
+
+    _grow_sparse(id);
+    _sparse[id] = _dense.size();
+    _entities.push_back(id);
+    return _dense.emplace_back(std::forward<Params>(params)...);
+}
+
+template <typename Component> void PackedArray<Component>::erase(size_type id)
+{
+    if (!contains(id))
+        return;
+
+    size_type slot = _sparse[id];
+    size_type last = _dense.size() - 1;
+
+    // Move the last live component into the hole so the dense array stays packed
+    if (slot != last)
+    {
+        _dense[slot] = std::move(_dense[last]);
+        _entities[slot] = _entities[last];
+        _sparse[_entities[slot]] = slot;
+    }
+
+    _dense.pop_back();
+    _entities.pop_back();
+    _sparse[id] = npos;
+}
+
+template <typename Component> void PackedArray<Component>::clear()
+{
+    _dense.clear();
+    _entities.clear();
+    _sparse.clear();
+}
+
+template <typename Component> void PackedArray<Component>::move_to(size_type id, size_type n)
+{
+    size_type slot = _sparse[id];
+
+    if (slot == n)
+        return;
+
+    std::swap(_dense[slot], _dense[n]);
+    std::swap(_entities[slot], _entities[n]);
+    _sparse[_entities[slot]] = slot;
+    _sparse[_entities[n]] = n;
+}
+
+template <typename Component> void PackedArray<Component>::_grow_sparse(size_type id)
+{
+    if (id >= _sparse.size())
+    {
+        _sparse.resize(id + 1, npos);
+    }
+}
+
+template <typename Component> std::ostream &operator<<(std::ostream &os, const PackedArray<Component> &packed_array)
+{
+    os << "PackedArray " << ComponentName<Component>::get() << ": [";
+    for (size_t n = 0; n < packed_array.size(); ++n)
+    {
+        os << packed_array.id_at(n) << ": " << packed_array.value_at(n);
+        if (n < packed_array.size() - 1)
+        {
+            os << ", ";
+        }
+    }
+    os << "]";
+    return os;
+}
+
+}  // namespace server
+
+#endif  // PACKED_ARRAY_HPP
@@ -0,0 +1,67 @@
+#ifndef PREFAB_HPP
+#define PREFAB_HPP
+
+#include "CommandBuffer.hpp"
+#include "Entity.hpp"
+#include "Registry.hpp"
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace server
+{
+
+// Template of an entity: the components every instance starts with, spawned in one call.
+// Once reserve() sized a registry for it, spawning up to that many instances at once doesn't reallocate anything.
+template <typename... Components> class Prefab
+{
+  public:
+    Prefab(Components... components) : _components(std::move(components)...) {}
+
+    // Room for count more instances alive at once, in the registry and in its command buffer
+    void reserve(Registry &registry, size_t count) const
+    {
+        registry.reserve_components<Components...>(count);
+        registry.commands().reserve<Components...>(count);
+    }
+
+    // The given components (of the prefab's types) replace the template's ones
+    template <typename... Overrides> Entity spawn(Registry &registry, Overrides &&...overrides) const
+    {
+        Entity entity = registry.spawn_entity();
+        std::tuple<Components...> components = instance(std::forward<Overrides>(overrides)...);
+
+        std::apply([&](auto &...component) { (registry.add_component(entity, std::move(component)), ...); },
+                   components);
+        return entity;
+    }
+
+    // Recorded in the command buffer, the instance is alive after the next flush
+    template <typename... Overrides> Entity spawn(CommandBuffer &commands, Overrides &&...overrides) const
+    {
+        Entity entity = commands.spawn_entity();
+        std::tuple<Components...> components = instance(std::forward<Overrides>(overrides)...);
+
+        std::apply([&](auto &...component) { (commands.add_component(entity, std::move(component)), ...); },
+                   components);
+        return entity;
+    }
+
+  private:
+    template <typename... Overrides> std::tuple<Components...> instance(Overrides &&...overrides) const
+    {
+        std::tuple<Components...> components = _components;
+
+        ((std::get<std::decay_t<Overrides>>(components) = std::forward<Overrides>(overrides)), ...);
+        return components;
+    }
+
+  private:
+    std::tuple<Components...> _components;
+};
+
+}  // namespace server
+
+#endif  // PREFAB_HPP
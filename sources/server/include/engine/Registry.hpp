@@ -1,15 +1,27 @@
 #ifndef REGISTRY_HPP
 #define REGISTRY_HPP
 
+#include "CommandBuffer.hpp"
+#include "ComponentId.hpp"
+#include "ComponentStorage.hpp"
 #include "Entity.hpp"
-#include "SparseArray.hpp"
+#include "IndexedZipper.hpp"
+#include "SystemAccess.hpp"
+#include "ThreadPool.hpp"
 
-#include <any>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
-#include <typeindex>
-#include <unordered_map>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Components touched by one parallel_chunks chunk, sized to stay in L2 while a worker updates them
+#define PARALLEL_CHUNK_BYTES (64 * 1024)
 
 namespace server
 {
@@ -17,110 +29,234 @@ namespace server
 class Registry
 {
   public:
+    Registry() : _commands(*this) {}
+    Registry(Registry const &) = delete;
+    Registry &operator=(Registry const &) = delete;
+
     // Component Registration and Retrieval
-    template <typename Component> SparseArray<Component> &register_component()
+    // The container type (SparseArray or PackedArray) is chosen per component by ComponentStorage
+    template <typename Component> ComponentArray<Component> &register_component()
     {
-        auto typeIndex = std::type_index(typeid(Component));
+        size_t id = ComponentId::get<Component>();
+
+        if (id >= _components_arrays.size())
+            _components_arrays.resize(id + 1);
 
-        // If the component type doesn't exist, create a new sparse array
-        if (_components_arrays.find(typeIndex) == _components_arrays.end())
+        // If the component type doesn't exist, create a new component array
+        auto &storage = _components_arrays[id];
+        if (!storage)
         {
-            auto sparseArray = std::make_shared<SparseArray<Component>>();
-            _components_arrays[typeIndex] = std::make_shared<std::any>(sparseArray);
+            auto componentArray = std::make_unique<TypedComponentArray<Component>>();
 
-            // Store a removal function for this component type
-            _component_removers[typeIndex] = [this](const Entity &entity) {
-                auto &componentArray = get_components<Component>();
-                componentArray.erase(static_cast<size_t>(entity));
-            };
+            // Arrays registered after reserve() get the same capacity
+            if (_reserved > 0)
+                componentArray->reserve(_reserved, std::max(_reserved, _entity_slots.size()));
+            storage = std::move(componentArray);
         }
 
-        // Return the sparse array for this component type
-        return *std::any_cast<std::shared_ptr<SparseArray<Component>>>(*_components_arrays[typeIndex]);
+        return static_cast<TypedComponentArray<Component> &>(*storage).array;
     }
 
-    template <typename Component> SparseArray<Component> &get_components()
+    template <typename Component> ComponentArray<Component> &get_components()
     {
         // Call the const version of get_components<Component>() on this object (cast to const Registry*),
         // then use const_cast to remove the constness from the returned reference, allowing modifications.
         // This is a workaround to avoid code duplication, with minimal overhead (only one extra function call)
-        return const_cast<SparseArray<Component> &>(static_cast<const Registry *>(this)->get_components<Component>());
+        return const_cast<ComponentArray<Component> &>(
+            static_cast<const Registry *>(this)->get_components<Component>());
+    }
+
+    // A single indexed load: the component's id is its slot in the table
+    template <typename Component> const ComponentArray<Component> &get_components() const
+    {
+        size_t id = ComponentId::get<Component>();
+
+        if (id < _components_arrays.size() && _components_arrays[id])
+            return static_cast<const TypedComponentArray<Component> &>(*_components_arrays[id]).array;
+
+        // If no array exists, throw an exception
+        throw std::runtime_error("Component type not registered");
     }
 
-    template <typename Component> const SparseArray<Component> &get_components() const
+    // Query over every entity owning all the given components, yields (id, components &...)
+    // ex: for (auto &&[id, pos, vel] : registry.view<PositionComponent, VelocityComponent>())
+    // The smallest component array drives the iteration. Spawning or killing entities while iterating
+    // invalidates the view (PackedArray erase moves components around).
+    template <typename... Components> IndexedZipper<ComponentArray<Components>...> view()
     {
-        auto typeIndex = std::type_index(typeid(Component));
+        return IndexedZipper<ComponentArray<Components>...>(register_component<Components>()...);
+    }
 
-        // Find and return the sparse array for this component type
-        auto it = _components_arrays.find(typeIndex);
-        if (it != _components_arrays.end())
+    // Moves the entities owning every component to the front of the components' arrays, in the same order, and returns
+    // how many there are: data()[n] of each array then belongs to the same entity for n < the returned count, which
+    // lets kernels run on plain arrays. The first component's order is kept, the others follow it. Arrays already
+    // grouped that way are only compared, so calling it every tick is cheap while the entities stay the same.
+    // Reorders the arrays: a system calling it must declare them all as written.
+    template <typename Leader, typename... Components> size_t group()
+    {
+        static_assert((std::is_same_v<ComponentArray<Leader>, PackedArray<Leader>> && ... &&
+                       std::is_same_v<ComponentArray<Components>, PackedArray<Components>>),
+                      "Only components stored in a PackedArray can be grouped");
+
+        auto &leader = register_component<Leader>();
+        auto arrays = std::tie(register_component<Components>()...);
+        size_t count = 0;
+
+        for (size_t n = 0; n < leader.size(); ++n)
         {
-            try
-            {
-                return *std::any_cast<std::shared_ptr<SparseArray<Component>>>(*(it->second));
-            } catch (const std::bad_any_cast &e)
+            size_t id = leader.id_at(n);
+
+            bool aligned = std::apply(
+                [count, id](auto &...others) { return ((count < others.size() && others.id_at(count) == id) && ...); },
+                arrays);
+            if (!aligned)
             {
-                std::cerr << "Type mismatch: expected std::shared_ptr<SparseArray<Component>>, but got "
-                          << it->second->type().name() << "\n";
-                throw;
+                bool owned = std::apply([id](auto &...others) { return (others.contains(id) && ...); }, arrays);
+                if (!owned)
+                    continue;
+                std::apply([count, id](auto &...others) { (others.move_to(id, count), ...); }, arrays);
             }
+            leader.move_to(id, count);
+            ++count;
         }
+        return count;
+    }
 
-        // If no array exists, throw an exception
-        throw std::runtime_error("Component type not registered");
+    // Calls kernel(first, n) for the entities [first, first + n) of the first count ones of a group, split in chunks
+    // of about PARALLEL_CHUNK_BYTES of Components run on the thread pool (on the calling thread without a pool or for
+    // a single chunk). kernel may only write the components of the entities it is given.
+    template <typename... Components, typename Kernel> void parallel_chunks(size_t count, Kernel &&kernel)
+    {
+        size_t chunkSize = std::max<size_t>(PARALLEL_CHUNK_BYTES / (sizeof(Components) + ...), 1);
+        size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+        if (_thread_pool == nullptr || chunks <= 1)
+        {
+            kernel(0, count);
+            return;
+        }
+        _thread_pool->run(chunks, [&](size_t chunk) {
+            size_t first = chunk * chunkSize;
+            kernel(first, std::min(chunkSize, count - first));
+        });
     }
 
     // Entity Management
     Entity spawn_entity()
     {
-        size_t id = 0;
+        Entity entity = reserve_entity();
 
-        if (!_reusable_entity.empty())
-        {
-            // Reuse an ID from the pool
-            id = _reusable_entity.back();
-            _reusable_entity.pop_back();
-        } else
+        activate_entity(entity);
+        return entity;
+    }
+
+    // Capacity for that many live entities: the entity bookkeeping and every component array, including the ones
+    // registered later, are sized so spawning up to that many entities doesn't reallocate
+    void reserve(size_t entities)
+    {
+        size_t ids = std::max(entities, _entity_slots.size());
+
+        _reserved = std::max(_reserved, entities);
+        reserve_entities(entities, ids);
+        for (auto &storage : _components_arrays)
         {
-            // Use the next available ID
-            id = _next_entity++;
+            if (storage)
+                storage->reserve(entities, ids);
         }
+    }
 
-        // Add the entity to the active entity list
-        Entity entity(id);
-        _entities.push_back(entity);
-        return entity;
+    // Capacity for count more entities owning the components, on top of the live ones (see Prefab::reserve)
+    template <typename... Components> void reserve_components(size_t count)
+    {
+        // Worst case, none of them reuses an id
+        size_t ids = _entity_slots.size() + count;
+
+        reserve_entities(_entities.size() + count, ids);
+        (register_component<Components>().reserve(get_components<Components>().size() + count, ids), ...);
     }
 
+    // O(1), stale handles (killed, or whose id was recycled since) are ignored
     void kill_entity(const Entity &entity)
     {
+        if (!is_alive(entity))
+            return;
+
         // Remove components for this entity
-        for (auto &remover : _component_removers)
+        for (auto &storage : _components_arrays)
         {
-            remover.second(entity);
+            if (storage)
+                storage->erase(&entity, 1);
         }
+        release_entity(entity);
+    }
 
-        // Remove the entity from the active list
-        auto it = std::find(_entities.begin(), _entities.end(), entity);
-        if (it != _entities.end())
+    bool is_alive(const Entity &entity) const
+    {
+        return entity._id < _entity_slots.size() && _entity_slots[entity._id].live != NOT_LIVE &&
+               _entity_slots[entity._id].generation == entity._generation;
+    }
+
+    // Handle of the entity living at id (e.g. an id yielded by a view), an invalid Entity if there is none
+    Entity entity_at(size_t id) const
+    {
+        if (id >= _entity_slots.size() || _entity_slots[id].live == NOT_LIVE)
+            return Entity();
+        return Entity(id, _entity_slots[id].generation);
+    }
+
+    const std::vector<Entity> &get_active_entities() const { return _entities; }
+
+    // Structural changes to make while iterating, see CommandBuffer. Flushed at the end of run_systems
+    CommandBuffer &commands() { return _commands; }
+
+    // Applies the recorded commands, the component arrays must not be iterated while it runs
+    void flush_commands()
+    {
+        CommandBuffer &commands = _commands;
+
+        for (const Entity &entity : commands._spawned)
+        {
+            activate_entity(entity);
+        }
+        for (auto &pending : commands._components)
+        {
+            if (pending)
+                pending->apply(*this);
+        }
+
+        // Every array drops all the dying entities in one pass, a kill recorded twice is only released once
+        std::vector<Entity> &killed = commands._killed;
+        killed.erase(std::remove_if(killed.begin(), killed.end(),
+                                    [this](const Entity &entity) { return !is_alive(entity); }),
+                     killed.end());
+        if (!killed.empty())
         {
-            _entities.erase(it);
+            for (auto &storage : _components_arrays)
+            {
+                if (storage)
+                    storage->erase(killed.data(), killed.size());
+            }
+            for (const Entity &entity : killed)
+            {
+                if (is_alive(entity))
+                    release_entity(entity);
+            }
         }
 
-        // Recycle the entity ID
-        _reusable_entity.push_back(entity);
+        commands._spawned.clear();
+        killed.clear();
     }
 
     // Component Management
     template <typename Component>
-    typename SparseArray<Component>::reference_type add_component(const Entity &entity, Component &&component)
+    typename ComponentArray<Component>::reference_type add_component(const Entity &entity, Component &&component)
     {
         auto &componentArray = register_component<Component>();
         return componentArray.insert_at(static_cast<size_t>(entity), std::forward<Component>(component));
     }
 
     template <typename Component, typename... Params>
-    typename SparseArray<Component>::reference_type emplace_component(const Entity &entity, Params &&...params)
+    typename ComponentArray<Component>::reference_type emplace_component(const Entity &entity, Params &&...params)
     {
         auto &componentArray = register_component<Component>();
         return componentArray.emplace_at(static_cast<size_t>(entity), std::forward<Params>(params)...);
@@ -128,14 +264,10 @@ class Registry
 
     template <typename Component> void remove_component(const Entity &entity)
     {
-        auto typeIndex = std::type_index(typeid(Component));
+        size_t id = ComponentId::get<Component>();
 
-        // Find the removal function for this component type
-        auto it = _component_removers.find(typeIndex);
-        if (it != _component_removers.end())
-        {
-            it->second(entity);
-        }
+        if (id < _components_arrays.size() && _components_arrays[id])
+            _components_arrays[id]->erase(&entity, 1);
     }
 
     // template <typename... Components, typename Function>
@@ -147,41 +279,231 @@ class Registry
     //     _systems.push_back(system_lambda);
     // }
 
-    template <typename... Components, typename Function> void add_system(Function const &func)
+    // Accesses declare what the system touches: Read<C>, Write<C> (or just C) and Entities, see SystemAccess.hpp.
+    // func gets the arrays of the declared components, in order: func(registry, ComponentArray<C> &...).
+    // Calling ex:
+    // registry.add_system<Write<PositionComponent>, Read<VelocityComponent>>(position_system);
+    template <typename... Accesses, typename Function> void add_system(Function const &func)
     {
-        // Calling ex:
-        // registry.add_system<PositionComponent, VelocityComponent>(position_system);
-        auto system_lambda = [this, &func]() { func(*this, get_components<Components>()...); };
-
-        _systems.push_back(system_lambda);
+        auto arrays = std::tuple_cat(system_arrays<Accesses>()...);
+        auto system_lambda = [this, &func, arrays]() {
+            std::apply([this, &func](auto &...components) { func(*this, components...); }, arrays);
+        };
+
+        System system {system_lambda, {}, {}};
+        (declare_access<Accesses>(system), ...);
+        _systems.push_back(std::move(system));
+        _stages.clear();
     }
 
-    void run_systems()
+    // Systems are run by stages, the systems of a stage don't conflict (nothing written by one is touched by another)
+    // and run concurrently on the thread pool, if any. A system runs after every system registered before it that it
+    // conflicts with, so the result is the same as running them one after the other in registration order.
+    // dt is the fixed tick length in seconds, systems read it back through delta_time()
+    void run_systems(float dt)
     {
-        for (auto &system : _systems)
+        _delta_time = dt;
+        if (_stages.empty())
+            build_stages();
+
+        for (const auto &stage : _stages)
         {
-            system();
+            if (_thread_pool != nullptr && stage.size() > 1)
+            {
+                _thread_pool->run(stage.size(), [this, &stage](size_t i) { _systems[stage[i]].run(); });
+                continue;
+            }
+            for (size_t system : stage)
+            {
+                _systems[system].run();
+            }
         }
+
+        // Sync point: what was recorded this tick (by the systems or before them) is applied once nothing iterates
+        flush_commands();
     }
 
-    void clear_systems() { _systems.clear(); }
+    void clear_systems()
+    {
+        _systems.clear();
+        _stages.clear();
+    }
+
+    // Pool running the systems of a stage concurrently, nullptr runs everything on the calling thread
+    void set_thread_pool(ThreadPool *pool) { _thread_pool = pool; }
+    ThreadPool *thread_pool() const { return _thread_pool; }
+
+    float delta_time() const { return _delta_time; }
 
     friend std::ostream &operator<<(std::ostream &os, const Registry &registry);
 
   private:
-    // Associative container for component arrays
-    std::unordered_map<std::type_index, std::shared_ptr<std::any>> _components_arrays;
+    friend class CommandBuffer;
+
+    // Component array whose type is only known by the derived class, the operations every array needs
+    struct AnyComponentArray
+    {
+        virtual ~AnyComponentArray() = default;
+        virtual void erase(const Entity *entities, size_t count) = 0;  // Removes a whole batch of entities at once
+        virtual void reserve(size_t count, size_t ids) = 0;
+    };
+
+    template <typename Component> struct TypedComponentArray : AnyComponentArray
+    {
+        void erase(const Entity *entities, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                array.erase(static_cast<size_t>(entities[i]));
+            }
+        }
+        void reserve(size_t count, size_t ids) override { array.reserve(count, ids); }
+
+        ComponentArray<Component> array;
+    };
+
+    struct System
+    {
+        std::function<void()> run;
+        std::vector<size_t> reads;  // ComponentIds
+        std::vector<size_t> writes;
+    };
+
+    // The component array passed to a system for this access, if any
+    template <typename Access> auto system_arrays()
+    {
+        using Traits = SystemAccess<Access>;
+
+        if constexpr (Traits::passed)
+            return std::tuple<ComponentArray<typename Traits::component> &>(
+                register_component<typename Traits::component>());
+        else
+            return std::tuple<>();
+    }
+
+    template <typename Access> static void declare_access(System &system)
+    {
+        using Traits = SystemAccess<Access>;
+
+        auto &accesses = Traits::write ? system.writes : system.reads;
+        accesses.push_back(ComponentId::get<typename Traits::component>());
+    }
+
+    static bool conflicts(const System &first, const System &second)
+    {
+        auto touches = [](const System &system, size_t type) {
+            return std::find(system.reads.begin(), system.reads.end(), type) != system.reads.end() ||
+                   std::find(system.writes.begin(), system.writes.end(), type) != system.writes.end();
+        };
 
-    // Container for component removal functions
-    std::unordered_map<std::type_index, std::function<void(const Entity &)>> _component_removers;
+        for (size_t type : first.writes)
+        {
+            if (touches(second, type))
+                return true;
+        }
+        for (size_t type : second.writes)
+        {
+            if (touches(first, type))
+                return true;
+        }
+        return false;
+    }
+
+    // A system's stage is one past the last stage of the earlier systems it conflicts with
+    void build_stages()
+    {
+        std::vector<size_t> stageOf(_systems.size(), 0);
+
+        _stages.clear();
+        for (size_t system = 0; system < _systems.size(); ++system)
+        {
+            for (size_t earlier = 0; earlier < system; ++earlier)
+            {
+                if (conflicts(_systems[earlier], _systems[system]))
+                    stageOf[system] = std::max(stageOf[system], stageOf[earlier] + 1);
+            }
+            if (stageOf[system] >= _stages.size())
+                _stages.resize(stageOf[system] + 1);
+            _stages[stageOf[system]].push_back(system);
+        }
+    }
+
+    // Room in the active list, the slots and the recycled ids for live entities whose ids are below ids
+    void reserve_entities(size_t live, size_t ids)
+    {
+        _entities.reserve(live);
+        _entity_slots.reserve(ids);
+        _reusable_entity.reserve(ids);
+    }
+
+    // Takes a free id, the entity isn't live until activate_entity
+    Entity reserve_entity()
+    {
+        size_t id = 0;
+
+        if (!_reusable_entity.empty())
+        {
+            // Reuse an ID from the pool, its generation was bumped when it was killed
+            id = _reusable_entity.back();
+            _reusable_entity.pop_back();
+        } else
+        {
+            // Use the next available ID
+            id = _next_entity++;
+            _entity_slots.push_back({0, NOT_LIVE});
+        }
+        return Entity(id, _entity_slots[id].generation);
+    }
+
+    // Adds the entity to the active entity list
+    void activate_entity(const Entity &entity)
+    {
+        _entity_slots[entity._id].live = _entities.size();
+        _entities.push_back(entity);
+    }
+
+    // Removes the entity from the active list (its components must already be gone), the last live entity takes its
+    // place, and recycles the id: every handle to it is stale from now on
+    void release_entity(const Entity &entity)
+    {
+        EntitySlot &slot = _entity_slots[entity._id];
+        Entity last = _entities.back();
+
+        _entities[slot.live] = last;
+        _entity_slots[last._id].live = slot.live;
+        _entities.pop_back();
+
+        slot.live = NOT_LIVE;
+        ++slot.generation;
+        _reusable_entity.push_back(entity._id);
+    }
+
+  private:
+    // Component arrays indexed by ComponentId, nullptr for the types this registry never registered
+    std::vector<std::unique_ptr<AnyComponentArray>> _components_arrays;
 
     // Container for system functions
-    std::vector<std::function<void()>> _systems;
+    std::vector<System> _systems;
+    std::vector<std::vector<size_t>> _stages;  // Indexes in _systems, rebuilt when the systems change
+    ThreadPool *_thread_pool = nullptr;
+    float _delta_time = 0.0f;
 
     // Entity management
-    std::vector<Entity> _entities;
+    static constexpr size_t NOT_LIVE = static_cast<size_t>(-1);
+
+    struct EntitySlot
+    {
+        uint32_t generation;  // Bumped each time the id is killed
+        size_t live;          // Index in _entities, NOT_LIVE while the id is free
+    };
+
+    std::vector<Entity> _entities;          // Live entities, unordered
+    std::vector<EntitySlot> _entity_slots;  // id -> slot
     std::vector<size_t> _reusable_entity;
     size_t _next_entity = 0;
+    size_t _reserved = 0;  // Live entities reserve() sized the registry for
+
+    CommandBuffer _commands;
 };
 
 inline std::ostream &operator<<(std::ostream &os, const Registry &registry)
@@ -213,6 +535,85 @@ inline std::ostream &operator<<(std::ostream &os, const Registry &registry)
     return os;
 }
 
+////////////////////////////////////////////////////////////
+// CommandBuffer members, they need the complete Registry //
+////////////////////////////////////////////////////////////
+
+inline CommandBuffer::CommandBuffer(Registry &registry) : _registry(registry) {}
+
+inline Entity CommandBuffer::spawn_entity()
+{
+    Entity entity = _registry.reserve_entity();
+
+    _spawned.push_back(entity);
+    return entity;
+}
+
+inline void CommandBuffer::kill_entity(const Entity &entity)
+{
+    _killed.push_back(entity);
+}
+
+template <typename Component> void CommandBuffer::add_component(const Entity &entity, Component &&component)
+{
+    pending<Component>().added.emplace_back(entity, std::forward<Component>(component));
+}
+
+template <typename Component> void CommandBuffer::remove_component(const Entity &entity)
+{
+    pending<Component>().removed.push_back(entity);
+}
+
+template <typename... Components> void CommandBuffer::reserve(size_t count)
+{
+    _spawned.reserve(count);
+    (pending<Components>().added.reserve(count), ...);
+}
+
+inline bool CommandBuffer::empty() const
+{
+    for (const auto &pending : _components)
+    {
+        if (pending && !pending->empty())
+            return false;
+    }
+    return _spawned.empty() && _killed.empty();
+}
+
+template <typename Component> CommandBuffer::Pending<Component> &CommandBuffer::pending()
+{
+    size_t id = ComponentId::get<Component>();
+
+    if (id >= _components.size())
+        _components.resize(id + 1);
+
+    auto &pending = _components[id];
+
+    if (!pending)
+        pending = std::make_unique<Pending<Component>>();
+    return static_cast<Pending<Component> &>(*pending);
+}
+
+template <typename Component> void CommandBuffer::Pending<Component>::apply(Registry &registry)
+{
+    if (empty())
+        return;
+
+    auto &componentArray = registry.register_component<Component>();
+    for (auto &[entity, component] : added)
+    {
+        if (registry.is_alive(entity))
+            componentArray.insert_at(static_cast<size_t>(entity), std::move(component));
+    }
+    for (const Entity &entity : removed)
+    {
+        if (registry.is_alive(entity))
+            componentArray.erase(static_cast<size_t>(entity));
+    }
+    added.clear();
+    removed.clear();
+}
+
 }  // namespace server
 
 #endif  // REGISTRY_HPP
\ No newline at end of file
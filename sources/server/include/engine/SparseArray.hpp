@@ -37,6 +37,14 @@ template <typename Component> class SparseArray
     reference_type operator[](size_t idx);              // non-const version
     const_reference_type operator[](size_t idx) const;  // const version
 
+    // Element Access, nullptr when the slot is empty or out of bounds
+    Component *find(size_t idx);
+    const Component *find(size_t idx) const;
+    bool contains(size_t idx) const;
+
+    // Entity id stored at a slot, lets zippers walk SparseArray and PackedArray the same way
+    size_t id_at(size_type n) const;
+
     // Iterators
     iterator begin();
     const_iterator begin() const;
@@ -48,6 +56,8 @@ template <typename Component> class SparseArray
 
     // Capacity
     size_type size() const;
+    // Room for the slots of entities whose ids are below ids (count is only there to match PackedArray::reserve)
+    void reserve(size_type count, size_type ids);
 
     // Modifiers
     reference_type insert_at(size_type pos, Component const &);
@@ -121,6 +131,26 @@ typename SparseArray<Component>::const_reference_type SparseArray<Component>::op
     return _data[idx];
 }
 
+template <typename Component> Component *SparseArray<Component>::find(size_t idx)
+{
+    return contains(idx) ? &_data[idx].value() : nullptr;
+}
+
+template <typename Component> const Component *SparseArray<Component>::find(size_t idx) const
+{
+    return contains(idx) ? &_data[idx].value() : nullptr;
+}
+
+template <typename Component> bool SparseArray<Component>::contains(size_t idx) const
+{
+    return idx < _data.size() && _data[idx].has_value();
+}
+
+template <typename Component> size_t SparseArray<Component>::id_at(size_type n) const
+{
+    return n;
+}
+
 // Iterator Implementations
 template <typename Component> typename SparseArray<Component>::iterator SparseArray<Component>::begin()
 {
@@ -158,6 +188,11 @@ template <typename Component> typename SparseArray<Component>::size_type SparseA
     return _data.size();
 }
 
+template <typename Component> void SparseArray<Component>::reserve(size_type, size_type ids)
+{
+    _data.reserve(ids);
+}
+
 // Modifier Implementations
 template <typename Component>
 typename SparseArray<Component>::reference_type SparseArray<Component>::insert_at(size_type pos,
@@ -0,0 +1,124 @@
+#ifndef SPATIAL_HASH_HPP
+#define SPATIAL_HASH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace server
+{
+
+// Uniform grid broad phase, rebuilt every tick:
+//   clear() -> insert() every entity -> build() -> query() as many times as needed
+// Entries are bucketed with a counting sort so a cell's entries are contiguous and no allocation happens once the
+// buffers reached their peak size. Points outside the bounds are clamped into the border cells.
+class SpatialHash
+{
+  public:
+    struct Entry
+    {
+        size_t id;
+        float x;
+        float y;
+        uint32_t layers;  // bitmask matched against the query mask
+    };
+
+  public:
+    SpatialHash(float minX, float minY, float maxX, float maxY, float cellSize)
+        : _minX(minX), _minY(minY), _invCellSize(1.0f / cellSize),
+          _columns(static_cast<size_t>((maxX - minX) / cellSize) + 1),
+          _rows(static_cast<size_t>((maxY - minY) / cellSize) + 1), _cellStart((_columns * _rows) + 1, 0)
+    {}
+
+    void clear()
+    {
+        _staged.clear();
+        _stagedCell.clear();
+        _entries.clear();
+    }
+
+    void insert(size_t id, float x, float y, uint32_t layers)
+    {
+        _staged.push_back({id, x, y, layers});
+        _stagedCell.push_back(_cell(_column(x), _row(y)));
+    }
+
+    // Sorts the staged entries by cell, must be called after the last insert and before any query
+    void build()
+    {
+        std::fill(_cellStart.begin(), _cellStart.end(), 0);
+        for (size_t cell : _stagedCell)
+        {
+            ++_cellStart[cell + 1];
+        }
+        for (size_t cell = 1; cell < _cellStart.size(); ++cell)
+        {
+            _cellStart[cell] += _cellStart[cell - 1];
+        }
+
+        // _cellCursor[cell] is where the next entry of that cell is written
+        _cellCursor.assign(_cellStart.begin(), _cellStart.end() - 1);
+        _entries.resize(_staged.size());
+        for (size_t i = 0; i < _staged.size(); ++i)
+        {
+            _entries[_cellCursor[_stagedCell[i]]++] = _staged[i];
+        }
+    }
+
+    // Calls func(entry) for every entry matching the layer mask in the cells overlapping the box.
+    // The cells are a superset of the box, func still has to run the exact (narrow phase) test.
+    template <typename Function>
+    void query(float minX, float minY, float maxX, float maxY, uint32_t layers, Function &&func) const
+    {
+        size_t firstColumn = _column(minX);
+        size_t lastColumn = _column(maxX);
+        size_t firstRow = _row(minY);
+        size_t lastRow = _row(maxY);
+
+        for (size_t row = firstRow; row <= lastRow; ++row)
+        {
+            // Cells of a row are contiguous, so are their entries
+            size_t begin = _cellStart[_cell(firstColumn, row)];
+            size_t end = _cellStart[_cell(lastColumn, row) + 1];
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (_entries[i].layers & layers)
+                    func(_entries[i]);
+            }
+        }
+    }
+
+  private:
+    size_t _column(float x) const { return _clamp((x - _minX) * _invCellSize, _columns); }
+    size_t _row(float y) const { return _clamp((y - _minY) * _invCellSize, _rows); }
+    size_t _cell(size_t column, size_t row) const { return row * _columns + column; }
+
+    static size_t _clamp(float coordinate, size_t count)
+    {
+        // Clamped as a float: casting NaN or a value past SIZE_MAX is undefined
+        if (!(coordinate > 0.0f))
+            return 0;
+        if (coordinate >= static_cast<float>(count - 1))
+            return count - 1;
+        return static_cast<size_t>(coordinate);
+    }
+
+  private:
+    float _minX;
+    float _minY;
+    float _invCellSize;
+    size_t _columns;
+    size_t _rows;
+
+    std::vector<size_t> _cellStart;  // _cellStart[c] .. _cellStart[c + 1] are the entries of cell c
+    std::vector<size_t> _cellCursor;
+    std::vector<Entry> _entries;
+    std::vector<Entry> _staged;
+    std::vector<size_t> _stagedCell;
+};
+
+}  // namespace server
+
+#endif  // SPATIAL_HASH_HPP
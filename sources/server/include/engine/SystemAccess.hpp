@@ -0,0 +1,50 @@
+#ifndef SYSTEM_ACCESS_HPP
+#define SYSTEM_ACCESS_HPP
+
+namespace server
+{
+
+// Access a system declares for each component it is given, see Registry::add_system.
+// A plain component type means Write<Component>.
+template <typename Component> struct Read
+{};
+
+template <typename Component> struct Write
+{};
+
+// The entities themselves: spawning or killing through the command buffer, looking a handle up with entity_at.
+// Declared like a component but not passed to the system.
+struct Entities
+{};
+
+template <typename Access> struct SystemAccess
+{
+    using component = Access;
+    static constexpr bool write = true;
+    static constexpr bool passed = true;  // The system gets the component array as a parameter
+};
+
+template <typename Component> struct SystemAccess<Read<Component>>
+{
+    using component = Component;
+    static constexpr bool write = false;
+    static constexpr bool passed = true;
+};
+
+template <typename Component> struct SystemAccess<Write<Component>>
+{
+    using component = Component;
+    static constexpr bool write = true;
+    static constexpr bool passed = true;
+};
+
+template <> struct SystemAccess<Entities>
+{
+    using component = Entities;
+    static constexpr bool write = true;
+    static constexpr bool passed = false;
+};
+
+}  // namespace server
+
+#endif  // SYSTEM_ACCESS_HPP
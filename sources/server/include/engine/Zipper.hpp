@@ -1,16 +1,17 @@
 #ifndef ZIPPER_HPP
 #define ZIPPER_HPP
 
+#include "IndexedZipper.hpp"
 #include "ZipperIterator.hpp"
 
 namespace server
 {
 
+// Same iteration as IndexedZipper, without the entity id in the yielded tuple
 template <typename... Containers> class Zipper
 {
   public:
     using iterator = ZipperIterator<Containers...>;
-    using iterator_tuple = typename iterator::iterator_tuple;
 
   public:
     Zipper(Containers &...cs);
@@ -18,44 +19,29 @@ template <typename... Containers> class Zipper
     iterator begin();
     iterator end();
 
-  private:
-    // helper function to know the maximum index of our iterators.
-    static size_t _compute_size(Containers &...containers);
-    // helper function to compute an iterator_tuple that will allow us to build our end iterator.
-    static iterator_tuple _compute_end(Containers &...containers);
+    size_t size_hint() const;
 
   private:
-    iterator_tuple _begin;
-    iterator_tuple _end;
-    size_t _size;
+    IndexedZipper<Containers...> _indexed;
 };
 
-template <typename... Containers>
-Zipper<Containers...>::Zipper(Containers &...cs)
-    : _begin(std::make_tuple(cs.begin()...)), _end(_compute_end(cs...)), _size(_compute_size(cs...))
-{}
+template <typename... Containers> Zipper<Containers...>::Zipper(Containers &...cs) : _indexed(cs...) {}
 
 template <typename... Containers> typename Zipper<Containers...>::iterator Zipper<Containers...>::begin()
 {
-    return ZipperIterator<Containers...>(_begin, _size);
+    return ZipperIterator<Containers...>(_indexed.begin());
 }
 
 template <typename... Containers> typename Zipper<Containers...>::iterator Zipper<Containers...>::end()
 {
-    return ZipperIterator<Containers...>(_end, _size);
-}
-
-template <typename... Containers> size_t Zipper<Containers...>::_compute_size(Containers &...containers)
-{
-    return std::min({containers.size()...});
+    return ZipperIterator<Containers...>(_indexed.end());
 }
 
-template <typename... Containers>
-typename Zipper<Containers...>::iterator_tuple Zipper<Containers...>::_compute_end(Containers &...containers)
+template <typename... Containers> size_t Zipper<Containers...>::size_hint() const
 {
-    return std::make_tuple((containers.begin() + _compute_size(containers...))...);
+    return _indexed.size_hint();
 }
 
 }  // namespace server
 
-#endif  // ZIPPER_HPP
\ No newline at end of file
+#endif  // ZIPPER_HPP
@@ -2,7 +2,9 @@
 #define COMPONENT_NAME_HPP
 
 #include "EntityTypeComponent.hpp"
+#include "FireCooldownComponent.hpp"
 #include "HealthComponent.hpp"
+#include "InputComponent.hpp"
 #include "PositionComponent.hpp"
 #include "VelocityComponent.hpp"
 
@@ -42,6 +44,16 @@ template <> struct ComponentName<EntityTypeComponent>
     static std::string get() { return "EntityType"; }
 };
 
+template <> struct ComponentName<InputComponent>
+{
+    static std::string get() { return "Input"; }
+};
+
+template <> struct ComponentName<FireCooldownComponent>
+{
+    static std::string get() { return "FireCooldown"; }
+};
+
 }  // namespace server
 
 #endif  // COMPONENT_NAME_HPP
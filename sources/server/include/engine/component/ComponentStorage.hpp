@@ -0,0 +1,49 @@
+#ifndef COMPONENT_STORAGE_HPP
+#define COMPONENT_STORAGE_HPP
+
+#include "EntityTypeComponent.hpp"
+#include "HealthComponent.hpp"
+#include "PackedArray.hpp"
+#include "PositionComponent.hpp"
+#include "SparseArray.hpp"
+#include "VelocityComponent.hpp"
+
+namespace server
+{
+
+/////////////////////////////////////////////////////////////////////
+// Trait selecting the container the Registry stores a component in //
+/////////////////////////////////////////////////////////////////////
+
+// Components default to the id-indexed SparseArray (O(1) access, iteration walks every slot)
+template <typename T> struct ComponentStorage
+{
+    using type = SparseArray<T>;
+};
+
+// Hot components iterated by every system each tick are packed so systems only walk live components
+template <> struct ComponentStorage<PositionComponent>
+{
+    using type = PackedArray<PositionComponent>;
+};
+
+template <> struct ComponentStorage<VelocityComponent>
+{
+    using type = PackedArray<VelocityComponent>;
+};
+
+template <> struct ComponentStorage<HealthComponent>
+{
+    using type = PackedArray<HealthComponent>;
+};
+
+template <> struct ComponentStorage<EntityTypeComponent>
+{
+    using type = PackedArray<EntityTypeComponent>;
+};
+
+template <typename T> using ComponentArray = typename ComponentStorage<T>::type;
+
+}  // namespace server
+
+#endif  // COMPONENT_STORAGE_HPP
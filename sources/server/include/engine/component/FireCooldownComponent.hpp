@@ -0,0 +1,16 @@
+#ifndef FIRE_COOLDOWN_COMPONENT_HPP
+#define FIRE_COOLDOWN_COMPONENT_HPP
+
+namespace server
+{
+
+// Time between two shots of an entity, in seconds
+struct FireCooldownComponent
+{
+    float period;
+    float remaining;  // Until it may fire again, 0 when it can
+};
+
+}  // namespace server
+
+#endif  // FIRE_COOLDOWN_COMPONENT_HPP
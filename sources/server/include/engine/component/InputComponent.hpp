@@ -0,0 +1,21 @@
+#ifndef INPUT_COMPONENT_HPP
+#define INPUT_COMPONENT_HPP
+
+#include <cstdint>
+
+namespace server
+{
+
+// Input commands of the client a player belongs to
+struct InputComponent
+{
+    uint32_t sequence;   // Last command applied, acked to the client along the snapshots
+    float budget;        // Commands it may still apply, refilled each tick
+    float moveX = 0.0f;  // Movement of the commands received this tick, applied once they are all in
+    float moveY = 0.0f;
+    bool fire = false;   // One of the commands received this tick fires
+};
+
+}  // namespace server
+
+#endif  // INPUT_COMPONENT_HPP
@@ -4,6 +4,19 @@
 #include "Entity.hpp"
 #include "Manager.hpp"
 
+// Instances alive at once the registries are sized for, see reserveProjectiles
+#define MAX_BULLETS 128
+#define MAX_ORBS 64
+// Distance a player moves per input command, vertically (twice that horizontally). The client predicts its player
+// with the same steps.
+#define PLAYER_STEP 10.0f
+// Input commands a player may apply per second (the client sends 30), and at once: a message repeats the commands
+// before its own, they are applied together when the messages before were lost
+#define PLAYER_INPUT_RATE 36.0f
+#define PLAYER_INPUT_BURST 8.0f
+// Seconds between two shots of a player
+#define PLAYER_FIRE_COOLDOWN 0.5f
+
 namespace server
 {
 
@@ -11,7 +24,8 @@ int countPlayers(Registry &registry);
 bool mobsAlive(Registry &registry);
 void killAllEntitiesButPlayers(Registry &registry);
 void restartPlayerPositions(Manager &manager);
-VelocityComponent calculateOrbVelocity(PositionComponent pos1, PositionComponent pos2, float orbSpeed, int fps);
+// orbSpeed and the returned velocity are in units per second
+VelocityComponent calculateOrbVelocity(PositionComponent pos1, PositionComponent pos2, float orbSpeed);
 
 std::chrono::duration<float> getSceneElapsedTime(
     const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime);
@@ -20,12 +34,22 @@ Entity createBoss(Registry &registry, PositionComponent pos, VelocityComponent v
 Entity createPlayer(Manager &manager, uint32_t clientId, PositionComponent pos, VelocityComponent vel,
                     HealthComponent hp);
 Entity createMob(Registry &registry, PositionComponent pos, VelocityComponent vel, HealthComponent hp);
-Entity createBullet(Registry &registry, PositionComponent pos);
+// Recorded in the command buffer, the bullet is alive after the next flush
+Entity createBullet(CommandBuffer &commands, PositionComponent pos);
 Entity createOrb(Registry &registry, PositionComponent pos, VelocityComponent vel);
+// Sizes the registry for MAX_BULLETS bullets and MAX_ORBS orbs on top of the live entities, so bursts of them don't
+// reallocate the component arrays
+void reserveProjectiles(Registry &registry);
 
+// Applies the input commands received since the last tick, at most one input per player and tick. The commands older
+// than one already applied are dropped, so are the ones over the player's budget
 void processUserInput(Manager &manager,
-                      const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime);
-StateUpdateMessage processOutput(Manager &manager);
+                      const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime, float dt);
+// Fills stateMsg with the current entities and the input acks of the players, reusing the buffers it already owns
+void processOutput(Manager &manager, StateUpdateMessage &stateMsg);
+
+// Kills the players of the clients that left the room (disconnected or timed out)
+void removeDepartedPlayers(Manager &manager);
 
 // LOBBY utils
 bool processStartGame(Manager &manager);
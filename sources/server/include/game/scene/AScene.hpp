@@ -25,7 +25,7 @@ class AScene
     virtual void enter() = 0;
 
     virtual void update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                        SceneEvent &action) = 0;
+                        SceneEvent &action, float dt) = 0;
 
     void setManager(Manager &manager) { _manager = &manager; }
 
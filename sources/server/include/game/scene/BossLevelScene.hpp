@@ -3,6 +3,8 @@
 
 #include "AScene.hpp"
 
+#include <chrono>
+
 namespace server
 {
 
@@ -17,7 +19,10 @@ class BossLevelScene : public AScene
     void enter() override;
 
     void update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                SceneEvent &event) override;
+                SceneEvent &event, float dt) override;
+
+  private:
+    std::chrono::time_point<std::chrono::high_resolution_clock> _lastOrbTime;  // Last orb fired by the boss
 };
 
 }  // namespace server
@@ -17,7 +17,7 @@ class FirstLevelScene : public AScene
     void enter() override;
 
     void update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                SceneEvent &event) override;
+                SceneEvent &event, float dt) override;
 };
 
 }  // namespace server
@@ -17,7 +17,7 @@ class LobbyScene : public AScene
     void enter() override;
 
     void update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                SceneEvent &action) override;
+                SceneEvent &action, float dt) override;
 
   private:
     Manager &_manager;
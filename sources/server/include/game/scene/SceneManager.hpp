@@ -38,7 +38,8 @@ class SceneManager
     void prevScene();
     void atScene(size_t idx);
 
-    void update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime);
+    // dt is the fixed tick length in seconds
+    void update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime, float dt);
 
     size_t size() const;
     size_t currentSceneIdx() const;
@@ -4,6 +4,7 @@
 #include "AScene.hpp"
 #include "Entity.hpp"
 
+#include <chrono>
 #include <vector>
 
 namespace server
@@ -20,10 +21,13 @@ class ThirdLevelScene : public AScene
     void enter() override;
 
     void update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                SceneEvent &event) override;
+                SceneEvent &event, float dt) override;
 
   private:
     std::vector<Entity> _mobs;
+    bool _firstMobAlive;
+    bool _secondMobAlive;
+    std::chrono::time_point<std::chrono::high_resolution_clock> _lastOrbTime;  // Last orbs fired by the mobs
 };
 
 }  // namespace server
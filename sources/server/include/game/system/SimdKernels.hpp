@@ -0,0 +1,31 @@
+#ifndef SIMD_KERNELS_HPP
+#define SIMD_KERNELS_HPP
+
+#include "EntityTypeComponent.hpp"
+#include "HealthComponent.hpp"
+#include "PositionComponent.hpp"
+#include "VelocityComponent.hpp"
+
+#include <cstddef>
+
+namespace server
+{
+
+// Branchless kernels behind the movement systems, they work on component arrays grouped by Registry::group (the n-th
+// component of each array belongs to the same entity). {x, y} pairs are processed as interleaved float lanes:
+// 4 entities per instruction with AVX2 (build with SERVER_AVX2), 2 with SSE2, one at a time otherwise.
+// Every path gives the same results as the scalar one.
+
+// position += velocity * dt
+void integrate_positions(PositionComponent *positions, const VelocityComponent *velocities, size_t count, float dt);
+
+// Wraps around the world: vertically everything but bullets, horizontally everything but bullets and players
+void wrap_positions(PositionComponent *positions, const EntityTypeComponent *types, size_t count);
+
+// Kills bullets and orbs out of the world, keeps players horizontally inside it
+void bound_positions(PositionComponent *positions, HealthComponent *healths, const EntityTypeComponent *types,
+                     size_t count);
+
+}  // namespace server
+
+#endif  // SIMD_KERNELS_HPP
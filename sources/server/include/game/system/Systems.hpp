@@ -10,14 +10,15 @@
 namespace server
 {
 
-void position_system(Registry &r, SparseArray<PositionComponent> &pos, SparseArray<VelocityComponent> &vel);
-void position_wrapping_system(Registry &r, SparseArray<PositionComponent> &pos, SparseArray<EntityTypeComponent> &ts);
-void out_of_bounds_system(Registry &r, SparseArray<PositionComponent> &pos, SparseArray<HealthComponent> &healths,
-                          SparseArray<EntityTypeComponent> &ts);
+void position_system(Registry &r, ComponentArray<PositionComponent> &pos, ComponentArray<VelocityComponent> &vel);
+void position_wrapping_system(Registry &r, ComponentArray<PositionComponent> &pos,
+                              ComponentArray<EntityTypeComponent> &ts);
+void out_of_bounds_system(Registry &r, ComponentArray<PositionComponent> &pos,
+                          ComponentArray<HealthComponent> &healths, ComponentArray<EntityTypeComponent> &ts);
 
-void health_system(Registry &r, SparseArray<HealthComponent> &healths);
-void collision_system(Registry &r, SparseArray<PositionComponent> &pos, SparseArray<VelocityComponent> &vel,
-                      SparseArray<HealthComponent> &h, SparseArray<EntityTypeComponent> &ts);
+void health_system(Registry &r, ComponentArray<HealthComponent> &healths);
+void collision_system(Registry &r, ComponentArray<PositionComponent> &pos, ComponentArray<VelocityComponent> &vel,
+                      ComponentArray<HealthComponent> &h, ComponentArray<EntityTypeComponent> &ts);
 
 }  // namespace server
 
@@ -0,0 +1,71 @@
+#ifndef BATCH_SOCKET_HPP
+#define BATCH_SOCKET_HPP
+
+#include "Protocol.hpp"
+#include "SendBufferPool.hpp"
+
+#include <array>
+#include <asio.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#if defined(__linux__)
+    #include <sys/socket.h>
+    // Several datagrams per system call, recvmmsg/sendmmsg only exist on Linux
+    #define SERVER_BATCH_IO
+#endif
+
+// Datagrams received by one recvmmsg
+#define RECV_BATCH_SIZE 32
+// Datagrams sent by one sendmmsg
+#define SEND_BATCH_SIZE 64
+
+namespace server
+{
+
+// A datagram waiting to be sent, its buffer is held until it is
+struct OutgoingDatagram
+{
+    SendBufferPool::Buffer *buffer;
+    asio::ip::udp::endpoint endpoint;
+};
+
+// Batched I/O on the native handle of a UDP socket. Calls never block: they stop at the first datagram that would
+// (error is then asio::error::would_block), the caller waits on the asio socket before trying again.
+// Only built with SERVER_BATCH_IO, the server sends and receives one datagram at a time through asio elsewhere.
+class BatchSocket
+{
+  public:
+    BatchSocket(asio::ip::udp::socket &socket);
+    ~BatchSocket();
+    BatchSocket(BatchSocket const &) = delete;
+    BatchSocket &operator=(BatchSocket const &) = delete;
+
+    // Receives up to RECV_BATCH_SIZE datagrams, read with datagram() and sender() until the next call
+    size_t receive(asio::error_code &error);
+    std::span<const uint8_t> datagram(size_t index) const;
+    const asio::ip::udp::endpoint &sender(size_t index) const;
+
+    // Returns how many of the datagrams were sent, in order
+    size_t send(std::span<const OutgoingDatagram> datagrams, asio::error_code &error);
+
+  private:
+    asio::ip::udp::socket &_socket;
+
+    std::array<std::array<uint8_t, MAX_DATAGRAM_SIZE>, RECV_BATCH_SIZE> _recvBuffers;
+    std::array<asio::ip::udp::endpoint, RECV_BATCH_SIZE> _senders;
+    std::array<size_t, RECV_BATCH_SIZE> _sizes;
+
+#ifdef SERVER_BATCH_IO
+    // Headers pointing at the buffers above, or at the datagrams of the send in progress
+    std::array<mmsghdr, RECV_BATCH_SIZE> _recvHeaders;
+    std::array<iovec, RECV_BATCH_SIZE> _recvVectors;
+    std::array<mmsghdr, SEND_BATCH_SIZE> _sendHeaders;
+    std::array<iovec, SEND_BATCH_SIZE> _sendVectors;
+#endif
+};
+
+}  // namespace server
+
+#endif  // BATCH_SOCKET_HPP
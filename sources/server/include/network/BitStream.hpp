@@ -0,0 +1,54 @@
+#ifndef BIT_STREAM_HPP
+#define BIT_STREAM_HPP
+
+#include "SpanWriter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace server
+{
+
+// Appends values of any width (up to 32 bits) to a SpanWriter, least significant bit first.
+// flush() pads the last byte with zeros and must be called after the last write.
+class BitWriter
+{
+  public:
+    BitWriter(SpanWriter &writer);
+    ~BitWriter();
+
+    void write(uint32_t value, unsigned int bits);  // Only the low bits of value are written
+    void writeVarint(uint32_t value);               // 7 bits per group, the 8th is set when another group follows
+    void flush();
+
+  private:
+    SpanWriter &_writer;
+    uint64_t _scratch;    // Bits not written to the writer yet
+    unsigned int _count;  // Number of bits in _scratch
+};
+
+// Reads back what a BitWriter wrote, throws std::runtime_error past the end of the buffer
+class BitReader
+{
+  public:
+    BitReader(std::span<const uint8_t> buffer, size_t offset);
+    ~BitReader();
+
+    uint32_t read(unsigned int bits);
+    uint32_t readVarint();
+
+  private:
+    std::span<const uint8_t> _buffer;
+    size_t _offset;       // Next byte to load
+    uint64_t _scratch;    // Bits loaded but not read yet
+    unsigned int _count;  // Number of bits in _scratch
+};
+
+// Bits taken by value once written with writeVarint
+unsigned int varintBits(uint32_t value);
+
+}  // namespace server
+
+#endif  // BIT_STREAM_HPP
@@ -1,8 +1,8 @@
 #ifndef EXTENDED_NETWORK_HPP
 #define EXTENDED_NETWORK_HPP
 
-#include "Manager.hpp"
 #include "Network.hpp"
+#include "RoomManager.hpp"
 
 namespace server
 {
@@ -10,33 +10,39 @@ namespace server
 class ExtendedNetworkServer : public NetworkServer
 {
   public:
-    ExtendedNetworkServer(asio::io_context &io_context, unsigned short port, Manager &manager)
-        : NetworkServer(io_context, port, manager), _manager(manager)
+    ExtendedNetworkServer(asio::io_context &io_context, unsigned short port, RoomManager &rooms)
+        : NetworkServer(io_context, port, rooms), _rooms(rooms)
     {}
 
     void handleUserInput(const UserInputMessage &msg) override
     {
         NetworkServer::handleUserInput(
             msg);  // handle user input that this is tranform the message -> but then we puss it to the manager
-        _manager.pushInput(msg);  // Push user input to the manager
+        if (std::shared_ptr<Room> room = _rooms.find(msg.clientId))
+            room->getManager().pushInput(msg);  // Push user input to the manager of the client's room
     }
 
     // connect plus add to the manager
     void handleConnect(const ConnectMessage &msg, const asio::ip::udp::endpoint &endpoint) override
     {
         NetworkServer::handleConnect(msg, endpoint);
-        _manager.addClient(msg.clientId, endpoint);  // Add client to the manager
+        if (std::shared_ptr<Room> room = _rooms.find(msg.clientId))
+            room->getManager().addClient(msg.clientId, endpoint);  // Add client to the manager of its room
     }
 
     // disconnect plus remove from the manager
     void handleDisconnect(const DisconnectMessage &msg, const asio::ip::udp::endpoint &endpoint) override
     {
+        // Looked up first, the base class frees the client's seat
+        std::shared_ptr<Room> room = _rooms.find(msg.clientId);
+
         NetworkServer::handleDisconnect(msg, endpoint);
-        _manager.removeClient(msg.clientId);  // Remove client from the manager
+        if (room)
+            room->getManager().removeClient(msg.clientId);  // Remove client from the manager of its room
     }
 
   private:
-    Manager &_manager;
+    RoomManager &_rooms;
 };
 
 }  // namespace server
@@ -1,13 +1,32 @@
 #ifndef NETWORK_HPP
 #define NETWORK_HPP
 
-#include "Manager.hpp"
+#include "BatchSocket.hpp"
 #include "Protocol.hpp"
+#include "ReliableChannel.hpp"
+#include "RoomManager.hpp"
+#include "SendBufferPool.hpp"
+#include "SnapshotHistory.hpp"
 
+#include <array>
 #include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <span>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+// An input ack goes along this many snapshots in case some are lost, or until a newer one replaces it
+#define INPUT_ACK_SENDS 4
+// Input messages a client may send per second (twice the client's default input rate), and in a burst. The ones over
+// that are dropped before they reach the room, a flood can't fill its input ring
+#define INPUT_MESSAGE_RATE 60.0f
+#define INPUT_MESSAGE_BURST 16.0f
+// A seated client sending nothing for this long (it acks every snapshot, lobby included) is unseated
+#define CLIENT_TIMEOUT_MS 10000
+
 namespace server
 {
 
@@ -15,42 +34,134 @@ class NetworkServer
 {
   public:
     // Constructor
-    NetworkServer(asio::io_context &io_context, unsigned short port, Manager &manager);
+    NetworkServer(asio::io_context &io_context, unsigned short port, RoomManager &rooms);
     ~NetworkServer();  // Explicitly declare the destructor
 
     // Public methods
     void start();  // Start the server and begin listening
-    // ! manager state queue
-    void processManagerQueue();  // Periodically process the manager's state update queue
-    void processGameOver();
-    void updateGameState();                                  // To be implemented with ECS integration
-    void sendGameState(const StateUpdateMessage &stateMsg);  // To send game state to clients
+    void updateGameState();  // To be implemented with ECS integration
 
     // public allow the manager to use this form server -> to add to quequs when happen
     void virtual handleUserInput(const UserInputMessage &msg);
     void virtual handleConnect(const ConnectMessage &msg, const asio::ip::udp::endpoint &endpoint);
     void virtual handleDisconnect(const DisconnectMessage &msg, const asio::ip::udp::endpoint &endpoint);
+    void handleSnapshotAck(const SnapshotAckMessage &msg);
 
   private:
+    using Clock = std::chrono::steady_clock;
+
+    // Datagrams of one snapshot, shared between the clients getting the same one
+    struct Datagrams
+    {
+        std::array<SendBufferPool::Buffer *, MAX_SNAPSHOT_FRAGMENTS> buffers;
+        size_t count = 0;
+    };
+
+    // A client seated in a room, with its delta snapshot state
+    struct RoomClient
+    {
+        asio::ip::udp::endpoint endpoint;
+        uint32_t ackedSequence = 0;               // Last snapshot acked
+        SnapshotHistory trimmed;                  // Snapshots packed to fit the budget, as this client rebuilt them
+        InputAckMessage inputAck {};              // Last input ack of its player
+        uint32_t inputAckSends = 0;               // Snapshots it still goes along
+        uint32_t inputSequence = 0;               // Last input command forwarded to the room
+        float inputTokens = INPUT_MESSAGE_BURST;  // Input messages it may still send
+        Clock::time_point inputRefill {};         // Last time the tokens were refilled
+        Clock::time_point lastReceived {};        // Last datagram from it
+    };
+
+    // Network side of a room, only touched on the strand
+    struct RoomChannel
+    {
+        std::weak_ptr<Room> room;
+        std::unordered_map<uint32_t, RoomClient> clients;  // Seated clients (clientId -> client)
+        SnapshotHistory snapshots;                         // Last snapshots sent, baselines of the deltas
+        StateUpdateMessage stateMsg;                       // Last state update popped from the manager
+        bool gameOverSent = false;                         // On the clients' reliable channels
+    };
+
+    // Reliable channel of a client (see ReliableMessage), opened by its connect and closed by its disconnect
+    struct ControlChannel
+    {
+        asio::ip::udp::endpoint endpoint;  // Where the client last sent from
+        ReliableChannel channel;
+    };
+
     // Internal utility functions
+    void openChannel(const std::shared_ptr<Room> &room);  // Called by the room manager for each new room
+    // Called from the game loop, schedules processManagerQueue/processGameOver of the room on the strand
+    void notifyOutput(uint32_t roomId, const std::shared_ptr<std::atomic<bool>> &pending);
+    void processManagerQueue(RoomChannel &channel);  // Send every state update waiting in the room manager
+    void processGameOver(uint32_t roomId);           // Send the game over message once the room's game is over
+    void sendGameState(RoomChannel &channel, const StateUpdateMessage &stateMsg);  // To the room's clients, as deltas
+    // Queues the client's input ack from the state update, the client reconciles its predicted player with it
+    void queueInputAck(RoomClient &client, uint32_t clientId, const StateUpdateMessage &stateMsg);
+    RoomChannel *findChannel(uint32_t clientId);  // Channel of the room the client is seated in
+    // Unseats a client gone without a disconnect, through handleDisconnect as if it had sent one
+    void dropClient(uint32_t clientId, const asio::ip::udp::endpoint &endpoint);
+    void touchClient(uint32_t clientId);  // A datagram came from the client, it isn't gone
+    void expireClients();                 // Drops the seated clients silent for CLIENT_TIMEOUT_MS
+    // False for the input commands to drop: replayed or older ones, and the ones over the client's rate. The lobby
+    // inputs (no sequence) always pass
+    bool acceptInput(const UserInputMessage &msg);
+
     void startReceive();                                                               // Begin asynchronous receive
     void handleReceive(const asio::error_code &error, std::size_t bytes_transferred);  // Handle incoming messages
-    void handleMessage(const std::vector<uint8_t> &data, const asio::ip::udp::endpoint &sender_endpoint);
+    void handleReadable(const asio::error_code &error);  // Batched receive: handle what the socket holds
+    // handleMessage for a datagram the client controls: a malformed one is logged and dropped
+    void handleDatagram(std::span<const uint8_t> data, const asio::ip::udp::endpoint &sender_endpoint);
+    void handleMessage(std::span<const uint8_t> data, const asio::ip::udp::endpoint &sender_endpoint);
+    void handleReliable(const ReliableView &msg, const asio::ip::udp::endpoint &sender_endpoint);
+
+    // Control messages: serialized into the client's reliable channel and sent until acked
+    template <typename Message, typename Serialize>
+    void sendControl(uint32_t clientId, const asio::ip::udp::endpoint &endpoint, const Message &msg,
+                     Serialize serialize);
+    void flushControl(uint32_t clientId, ControlChannel &control);  // Sends the messages due (new or not acked)
+    void startControlTimer();                                       // Resends every RELIABLE_RESEND_MS, expires clients
+    void sendReliable(const ReliableMessage &msg, std::span<const uint8_t> payload,
+                      const asio::ip::udp::endpoint &target_endpoint);
 
-    // Send utility
-    void sendMessage(const std::vector<uint8_t> &data, const asio::ip::udp::endpoint &target_endpoint);
+    // Send utility, the buffer goes back to the pool once the send completes (and the caller released it)
+    void sendMessage(SendBufferPool::Buffer *buffer, const asio::ip::udp::endpoint &target_endpoint);
+    // Serializes a fixed size message into a pooled buffer and sends it
+    template <typename Message, typename Serialize>
+    void sendMessage(const Message &msg, Serialize serialize, const asio::ip::udp::endpoint &target_endpoint);
+    // Serializes the delta into pooled buffers, split into FragmentMessages when it is bigger than a datagram
+    void buildDatagrams(const DeltaStateUpdateMessage &delta, Datagrams &datagrams);
+    void sendDatagrams(const Datagrams &datagrams, const asio::ip::udp::endpoint &target_endpoint);  // Queued
+    void flushDatagrams();  // Sends the queued datagrams, with sendmmsg when available
+    void releaseDatagrams(Datagrams &datagrams);
 
     // Server state
+    // Every handler touching the channels runs on the strand
+    asio::io_context &_io_context;
+    asio::strand<asio::io_context::executor_type> _strand;
     asio::ip::udp::socket socket_;
     asio::ip::udp::endpoint sender_endpoint_;
-    std::array<uint8_t, 1024> recv_buffer_;
+    std::array<uint8_t, MAX_DATAGRAM_SIZE> recv_buffer_;
+    BatchSocket _batch;  // recvmmsg/sendmmsg on socket_, with SERVER_BATCH_IO
+
+    // Rooms, all of them share the socket
+    RoomManager &_rooms;
+    std::unordered_map<uint32_t, std::unique_ptr<RoomChannel>> _channels;  // roomId -> channel
+
+    // Reliable channels of the clients, only touched on the strand
+    std::unordered_map<uint32_t, ControlChannel> _control;  // clientId -> channel
+    asio::steady_timer _controlTimer;
 
-    std::unordered_map<uint32_t, asio::ip::udp::endpoint> clients_;  // Map of connected clients (clientId -> endpoint)
+    // Every datagram is serialized into one of these, nothing is allocated per send
+    SendBufferPool _sendBuffers;
 
-    // manager related -> be able to get the manager info on the state queue
-    Manager &_manager;                     // Reference to the manager
-    std::thread _managerProcessingThread;  // Thread for processing the manager queue
-    bool _running = true;                  // Control flag for the processing thread
+    // Scratch buffers reused by sendGameState
+    DeltaStateUpdateMessage _delta;                             // Reused to build each delta
+    DeltaStateUpdateMessage _packed;                            // Reused to trim a delta over the budget
+    std::vector<EntityState> _rebuilt;                          // Reused to rebuild a trimmed snapshot
+    std::vector<std::pair<uint32_t, Datagrams>> _sharedDeltas;  // Deltas sent to every client with that baseline
+    std::array<uint8_t, MAX_SNAPSHOT_SIZE> _serialized;         // A delta too big for a datagram, before the split
+    std::vector<OutgoingDatagram> _outgoing;                    // Datagrams of the room's clients, sent together
+    uint32_t _fragmentGroup = 0;                                // groupId of the last fragmented message
 };
 
 }  // namespace server
@@ -2,11 +2,23 @@
 #define PROTOCOL_HPP
 
 #include "EntityTypeComponent.hpp"
+#include "SpanWriter.hpp"
 
 #include <asio.hpp>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
 #include <vector>
 
+// Largest datagram sent, leaves room for the IP/UDP headers (and tunnels) under the usual 1500 bytes MTU
+#define MAX_DATAGRAM_SIZE 1200
+// A snapshot never takes more datagrams than this, the entities that don't fit wait for the next tick
+#define MAX_SNAPSHOT_FRAGMENTS 4
+// Previous input commands repeated by each UserInputMessage, a command is only lost with that many messages in a row
+#define INPUT_REDUNDANCY 3
+
 // Ensure no padding in structures
 #pragma pack(push, 1)
 
@@ -20,7 +32,12 @@ enum class MessageType : uint16_t
     Disconnect = 2,
     StateUpdate = 3,
     UserInput = 4,
-    GameOver = 5
+    GameOver = 5,
+    DeltaStateUpdate = 6,
+    SnapshotAck = 7,
+    Fragment = 8,
+    Reliable = 9,
+    InputAck = 10
 };
 
 enum class GameOverType : uint16_t
@@ -72,11 +89,82 @@ struct EntityState
     uint8_t health;         // Health of the entity (see if needed)
 };
 
+// Last input command the server applied for a client, and where it left the client's player (Server to Client)
+struct InputAckMessage
+{
+    MessageHeader header;
+    uint32_t clientId;  // Unique ID of the client
+    uint32_t sequence;  // Sequence of the last UserInputMessage applied
+    float posX;         // Player position once the tick that applied it ran
+    float posY;
+};
+
 struct StateUpdateMessage
 {
     MessageHeader header;
-    uint32_t numEntities;               // Number of entities in the game
-    std::vector<EntityState> entities;  // List of entity states
+    uint32_t numEntities;                    // Number of entities in the game
+    std::vector<EntityState> entities;       // List of entity states
+    std::vector<InputAckMessage> inputAcks;  // Server side only, never serialized: one per player, sent to its client
+};
+
+// Fields of an EntityState present in an EntityDelta
+enum class EntityField : uint8_t
+{
+    ClientId = 1 << 0,
+    PosX = 1 << 1,
+    PosY = 1 << 2,
+    VelX = 1 << 3,
+    VelY = 1 << 4,
+    EntityType = 1 << 5,
+    Health = 1 << 6
+};
+
+// An entity that exists in both the baseline and the new snapshot, only the fields in fieldMask are sent
+struct EntityDelta
+{
+    uint8_t fieldMask;  // EntityField bits
+    EntityState state;  // state.entityId is always valid, other fields only if set in fieldMask
+};
+
+// Snapshot sent relative to a baseline snapshot the client acked (Server to Client)
+struct DeltaStateUpdateMessage
+{
+    MessageHeader header;
+    uint32_t sequence;                 // Sequence of this snapshot, starts at 1
+    uint32_t baseSequence;             // Snapshot it is relative to, 0 for none (every entity is created)
+    std::vector<EntityState> created;  // Entities missing from the baseline
+    std::vector<EntityDelta> updated;  // Entities with at least one changed field
+    std::vector<uint32_t> destroyed;   // Ids of the baseline entities that are gone
+};
+
+// One piece of a message bigger than MAX_DATAGRAM_SIZE (Server to Client)
+struct FragmentMessage
+{
+    MessageHeader header;
+    uint32_t groupId;              // Same for every fragment of a message
+    uint8_t fragmentIndex;         // 0 <= fragmentIndex < fragmentCount
+    uint8_t fragmentCount;         // Number of fragments of the message
+    std::vector<uint8_t> payload;  // Bytes [fragmentIndex * MAX_FRAGMENT_PAYLOAD, ...) of the message
+};
+
+// Control message (connect, disconnect, game over, lobby inputs) on the reliable channel of a client, both ways.
+// Resent until acked, handled once and in order. It also acks what its sender received, an ack alone has no payload.
+struct ReliableMessage
+{
+    MessageHeader header;
+    uint32_t clientId;             // Client the channel belongs to
+    uint32_t sequence;             // Of this message on the channel, from 1. 0 for an ack alone
+    uint32_t ack;                  // A sequence received from the peer, 0 for none
+    uint32_t ackBits;              // Bit i set: ack - 1 - i was received too
+    std::vector<uint8_t> payload;  // The control message, serialized
+};
+
+// Acknowledges the last snapshot the client rebuilt (Client to Server)
+struct SnapshotAckMessage
+{
+    MessageHeader header;
+    uint32_t clientId;  // Unique ID of the client
+    uint32_t sequence;  // Sequence of the acked snapshot
 };
 
 // ! revise this (inputs from the user)
@@ -97,32 +185,160 @@ enum class InputFlags : uint8_t
 struct UserInputMessage
 {
     MessageHeader header;
-    uint32_t clientId;   // Unique ID of the client
-    uint8_t inputFlags;  // Combined input flags
+    uint32_t clientId;                        // Unique ID of the client
+    uint32_t sequence;                        // Of the input command, from 1. 0 for the lobby inputs, never acked
+    uint8_t inputFlags;                       // Combined input flags
+    uint8_t previousFlags[INPUT_REDUNDANCY];  // Flags of the commands sequence - 1 - i, 0 before the first one
 };
 
 #pragma pack(pop)
 
+// Entities of a received StateUpdateMessage, decoded from the receive buffer only when they are read
+class EntityStateRange
+{
+  public:
+    class iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = EntityState;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = EntityState;
+
+        iterator() = default;
+        explicit iterator(const uint8_t *at) : _at(at) {}
+
+        EntityState operator*() const
+        {
+            EntityState state;
+            memcpy(&state, _at, sizeof(EntityState));
+            return state;
+        }
+        iterator &operator++()
+        {
+            _at += sizeof(EntityState);
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const iterator &other) const { return _at == other._at; }
+
+      private:
+        const uint8_t *_at = nullptr;
+    };
+
+    EntityStateRange() = default;
+    explicit EntityStateRange(std::span<const uint8_t> bytes) : _bytes(bytes) {}  // A whole number of EntityStates
+
+    iterator begin() const { return iterator(_bytes.data()); }
+    iterator end() const { return iterator(_bytes.data() + _bytes.size()); }
+    size_t size() const { return _bytes.size() / sizeof(EntityState); }
+    EntityState operator[](size_t n) const { return *iterator(_bytes.data() + n * sizeof(EntityState)); }
+
+  private:
+    std::span<const uint8_t> _bytes;
+};
+
+// Views of received messages, read in place: they point into the receive buffer and are only valid as long as it is
+struct StateUpdateView
+{
+    MessageHeader header;
+    uint32_t numEntities;
+    EntityStateRange entities;
+};
+
+struct FragmentView
+{
+    MessageHeader header;
+    uint32_t groupId;
+    uint8_t fragmentIndex;
+    uint8_t fragmentCount;
+    std::span<const uint8_t> payload;  // Bytes [fragmentIndex * MAX_FRAGMENT_PAYLOAD, ...) of the message
+};
+
+struct ReliableView
+{
+    MessageHeader header;
+    uint32_t clientId;
+    uint32_t sequence;
+    uint32_t ack;
+    uint32_t ackBits;
+    std::span<const uint8_t> payload;  // The control message
+};
+
+// Wire sizes
+#define DELTA_STATE_UPDATE_HEADER_SIZE (sizeof(MessageHeader) + 2 * sizeof(uint32_t) + 3 * sizeof(uint16_t))
+#define FRAGMENT_HEADER_SIZE (sizeof(MessageHeader) + sizeof(uint32_t) + 2 * sizeof(uint8_t))
+#define MAX_FRAGMENT_PAYLOAD (MAX_DATAGRAM_SIZE - FRAGMENT_HEADER_SIZE)
+#define RELIABLE_HEADER_SIZE (sizeof(MessageHeader) + 4 * sizeof(uint32_t))
+#define MAX_SNAPSHOT_SIZE (MAX_SNAPSHOT_FRAGMENTS * MAX_FRAGMENT_PAYLOAD)
+
+// Entities in deltas are bit-packed, positions and velocities are fixed point with 1/16 unit steps
+#define WIRE_FIXED_SCALE 16.0f
+#define WIRE_POS_BITS 16         // 4096 units wide window...
+#define WIRE_POS_MIN_X -1088.0f  // ...centered on the 1920x1080 world, positions outside are clamped
+#define WIRE_POS_MIN_Y -1508.0f
+#define WIRE_VEL_BITS 16         // Signed, +-2048 units per second
+#define WIRE_TYPE_BITS 3
+#define WIRE_HEALTH_BITS 8
+#define WIRE_FIELD_MASK_BITS 7
+
+// clientId of the entities that are not players, never sent
+#define NO_CLIENT_ID 42
+
+// Rounds the fields to the values a delta can carry
+void quantizeEntityState(EntityState &state);
+// Bits taken by an entry of the created/updated lists, counting its whole id (the wire only has the gap from the
+// previous id of the list, which is never bigger)
+size_t createdEntityBits(const EntityState &state);
+size_t updatedEntityBits(const EntityDelta &delta);
+// Bytes taken by the whole DeltaStateUpdateMessage
+size_t serializedDeltaStateUpdateSize(const DeltaStateUpdateMessage &msg);
+
 // Serialization and deserialization functions for each message and general header
-void serializeMessageHeader(const MessageHeader &header, std::vector<uint8_t> &buffer);
-void serializeConnectMessage(const ConnectMessage &msg, std::vector<uint8_t> &buffer);
-void serializeDisconnectMessage(const DisconnectMessage &msg, std::vector<uint8_t> &buffer);
-void serializeStateUpdateMessage(const StateUpdateMessage &msg, std::vector<uint8_t> &buffer);
-void serializeUserInputMessage(const UserInputMessage &msg, std::vector<uint8_t> &buffer);
+// The deserialize functions read from any contiguous bytes, e.g. the receive buffer itself
+// The serialize functions write into a buffer already big enough: sizeof the message for the fixed size ones,
+// serializedDeltaStateUpdateSize for deltas, FRAGMENT_HEADER_SIZE/RELIABLE_HEADER_SIZE + the payload for the others
+void serializeMessageHeader(const MessageHeader &header, SpanWriter &writer);
+void serializeConnectMessage(const ConnectMessage &msg, SpanWriter &writer);
+void serializeDisconnectMessage(const DisconnectMessage &msg, SpanWriter &writer);
+void serializeStateUpdateMessage(const StateUpdateMessage &msg, SpanWriter &writer);
+void serializeUserInputMessage(const UserInputMessage &msg, SpanWriter &writer);
+void serializeDeltaStateUpdateMessage(const DeltaStateUpdateMessage &msg, SpanWriter &writer);
+void serializeSnapshotAckMessage(const SnapshotAckMessage &msg, SpanWriter &writer);
+void serializeFragmentMessage(const FragmentMessage &msg, SpanWriter &writer);
+// Same with the payload given apart (msg.payload is ignored), e.g. a slice of a bigger serialized message
+void serializeFragmentMessage(const FragmentMessage &msg, std::span<const uint8_t> payload, SpanWriter &writer);
+void serializeReliableMessage(const ReliableMessage &msg, SpanWriter &writer);
+void serializeReliableMessage(const ReliableMessage &msg, std::span<const uint8_t> payload, SpanWriter &writer);
 
 // new
-void serializeGameOverMessage(const GameOverMessage &msg, std::vector<uint8_t> &buffer);
+void serializeGameOverMessage(const GameOverMessage &msg, SpanWriter &writer);
+void serializeInputAckMessage(const InputAckMessage &msg, SpanWriter &writer);
 
-void deserializeMessageHeader(const std::vector<uint8_t> &buffer, MessageHeader &header);
-void deserializeConnectMessage(const std::vector<uint8_t> &buffer, ConnectMessage &msg);
-void deserializeDisconnectMessage(const std::vector<uint8_t> &buffer, DisconnectMessage &msg);
-void deserializeStateUpdateMessage(const std::vector<uint8_t> &buffer, StateUpdateMessage &msg);
-void deserializeUserInputMessage(const std::vector<uint8_t> &buffer, UserInputMessage &msg);
+void deserializeMessageHeader(std::span<const uint8_t> buffer, MessageHeader &header);
+void deserializeConnectMessage(std::span<const uint8_t> buffer, ConnectMessage &msg);
+void deserializeDisconnectMessage(std::span<const uint8_t> buffer, DisconnectMessage &msg);
+void deserializeStateUpdateMessage(std::span<const uint8_t> buffer, StateUpdateMessage &msg);
+void deserializeStateUpdateMessage(std::span<const uint8_t> buffer, StateUpdateView &view);
+void deserializeUserInputMessage(std::span<const uint8_t> buffer, UserInputMessage &msg);
+void deserializeDeltaStateUpdateMessage(std::span<const uint8_t> buffer, DeltaStateUpdateMessage &msg);
+void deserializeSnapshotAckMessage(std::span<const uint8_t> buffer, SnapshotAckMessage &msg);
+void deserializeFragmentMessage(std::span<const uint8_t> buffer, FragmentMessage &msg);
+void deserializeFragmentMessage(std::span<const uint8_t> buffer, FragmentView &view);
+void deserializeReliableMessage(std::span<const uint8_t> buffer, ReliableMessage &msg);
+void deserializeReliableMessage(std::span<const uint8_t> buffer, ReliableView &view);
 
 // make the function to serialize and deseralize here and send to all the clients same way we do but not pushed quee direclyt from the manager
 // function manager to game over...
 // new
-void deserializeGameOverMessage(const std::vector<uint8_t> &buffer, GameOverMessage &msg);
+void deserializeGameOverMessage(std::span<const uint8_t> buffer, GameOverMessage &msg);
+void deserializeInputAckMessage(std::span<const uint8_t> buffer, InputAckMessage &msg);
 
 }  // namespace server
 
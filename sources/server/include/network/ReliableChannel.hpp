@@ -0,0 +1,111 @@
+#ifndef RELIABLE_CHANNEL_HPP
+#define RELIABLE_CHANNEL_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+// Interval at which a control message is sent again until it is acked
+#define RELIABLE_RESEND_MS 100
+// A control message still not acked after this long means the peer is gone
+#define RELIABLE_TIMEOUT_MS 10000
+// Messages received ahead of the next one to handle, the ones further ahead are dropped (and resent later)
+#define RELIABLE_WINDOW 32
+
+namespace server
+{
+
+// One end of a reliable ordered channel over UDP (see ReliableMessage), it doesn't send anything itself.
+// Sent messages are kept until acked and handed back by resend() every RELIABLE_RESEND_MS. Received messages are
+// handed out once each, in sequence order. Not thread safe, only used on the network strand.
+class ReliableChannel
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    ReliableChannel();
+    ~ReliableChannel();
+
+    // Sending: queues a serialized control message, resend() sends it the first time
+    uint32_t push(std::span<const uint8_t> message);
+    void acknowledge(uint32_t ack, uint32_t ackBits);  // Drops the messages the peer received
+    bool idle() const;                                 // Every message was acked
+    bool expired(Clock::time_point now) const;         // A message went unacked for RELIABLE_TIMEOUT_MS
+
+    // Calls send(sequence, message) for the messages never sent or not acked RELIABLE_RESEND_MS after their last send
+    template <typename Send> void resend(Clock::time_point now, Send send)
+    {
+        for (Pending &pending : _pending)
+        {
+            bool sent = (pending.sentAt != Clock::time_point());
+
+            if (sent && now - pending.sentAt < std::chrono::milliseconds(RELIABLE_RESEND_MS))
+                continue;
+            if (!sent)
+                pending.firstSentAt = now;
+            pending.sentAt = now;
+            send(pending.sequence, std::span<const uint8_t>(pending.message));
+        }
+    }
+
+    // Receiving: returns whether the message must be acked (it is new or a duplicate). The messages it made ready
+    // are passed to deliver(message) in order, before this returns.
+    template <typename Deliver> bool receive(uint32_t sequence, std::span<const uint8_t> message, Deliver deliver)
+    {
+        if (sequence == 0 || sequence >= _nextDelivery + RELIABLE_WINDOW)
+            return false;
+        if (sequence < _nextDelivery)
+            return true;
+
+        Early &early = _early[sequence % RELIABLE_WINDOW];
+        if (!early.received)
+        {
+            early.received = true;
+            early.message.assign(message.begin(), message.end());
+            _lastReceived = std::max(_lastReceived, sequence);
+        }
+        while (_early[_nextDelivery % RELIABLE_WINDOW].received)
+        {
+            Early &next = _early[_nextDelivery++ % RELIABLE_WINDOW];
+
+            next.received = false;
+            deliver(std::span<const uint8_t>(next.message));
+        }
+        return true;
+    }
+    uint32_t lastReceived() const;         // Newest sequence received, 0 for none
+    uint32_t ackBits(uint32_t ack) const;  // Which of the 32 sequences before ack were received
+
+  private:
+    struct Pending
+    {
+        uint32_t sequence;
+        std::vector<uint8_t> message;
+        Clock::time_point sentAt;  // Epoch until it is sent
+        Clock::time_point firstSentAt;
+    };
+
+    struct Early
+    {
+        bool received = false;
+        std::vector<uint8_t> message;
+    };
+
+    bool received(uint32_t sequence) const;
+
+    uint32_t _nextSequence = 1;
+    std::deque<Pending> _pending;  // By sequence
+
+    uint32_t _nextDelivery = 1;
+    uint32_t _lastReceived = 0;
+    std::array<Early, RELIABLE_WINDOW> _early;  // Sequences [_nextDelivery, _nextDelivery + RELIABLE_WINDOW)
+};
+
+}  // namespace server
+
+#endif  // RELIABLE_CHANNEL_HPP
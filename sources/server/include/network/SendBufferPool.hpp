@@ -0,0 +1,52 @@
+#ifndef SEND_BUFFER_POOL_HPP
+#define SEND_BUFFER_POOL_HPP
+
+#include "Protocol.hpp"
+#include "SpanWriter.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Send buffers allocated up front, more are only allocated when every one of them is in flight
+#define SEND_BUFFER_POOL_SIZE 256
+
+namespace server
+{
+
+// Datagram sized buffers serialized into and recycled once their sends complete, so sending allocates nothing.
+// A buffer is counted: acquire() hands it out with one reference, each send holds one more until it completes and
+// it goes back to the pool when the last one is released. Not thread safe, only used on the network strand.
+class SendBufferPool
+{
+  public:
+    struct Buffer
+    {
+        std::array<uint8_t, MAX_DATAGRAM_SIZE> bytes;
+        size_t size = 0;  // Bytes to send
+        size_t references = 0;
+
+        SpanWriter writer() { return SpanWriter(bytes); }  // Writes from the start of the buffer
+    };
+
+    SendBufferPool(size_t preallocated = SEND_BUFFER_POOL_SIZE);
+    ~SendBufferPool();
+    SendBufferPool(SendBufferPool const &) = delete;
+    SendBufferPool &operator=(SendBufferPool const &) = delete;
+
+    Buffer *acquire();
+    void retain(Buffer *buffer);
+    void release(Buffer *buffer);
+
+    size_t allocated() const;  // Buffers owned by the pool, in use or not
+
+  private:
+    std::vector<std::unique_ptr<Buffer>> _buffers;
+    std::vector<Buffer *> _free;
+};
+
+}  // namespace server
+
+#endif  // SEND_BUFFER_POOL_HPP
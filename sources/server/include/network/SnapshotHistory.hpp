@@ -0,0 +1,60 @@
+#ifndef SNAPSHOT_HISTORY_HPP
+#define SNAPSHOT_HISTORY_HPP
+
+#include "Protocol.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Number of past snapshots kept as delta baselines (~0.5s at 60 ticks per second)
+#define SNAPSHOT_HISTORY_SIZE 32
+
+namespace server
+{
+
+// Ring of the last snapshots sent, entities sorted by id. Clients ack a sequence and get the next snapshots as a
+// delta against it, as long as it is still in the ring.
+class SnapshotHistory
+{
+  public:
+    SnapshotHistory();
+    ~SnapshotHistory();
+
+    // Stores a sorted and quantized copy of the entities (reusing the oldest slot buffers), returns the new snapshot
+    // sequence
+    uint32_t push(const std::vector<EntityState> &entities);
+    // Same, under a sequence chosen by the caller (snapshots trimmed for a single client)
+    void store(uint32_t sequence, const std::vector<EntityState> &entities);
+
+    // Entities of the snapshot, nullptr for sequence 0 or a sequence that fell out of the ring
+    const std::vector<EntityState> *find(uint32_t sequence) const;
+    uint32_t latestSequence() const;
+
+  private:
+    struct Snapshot
+    {
+        uint32_t sequence = 0;
+        std::vector<EntityState> entities;
+    };
+
+    std::array<Snapshot, SNAPSHOT_HISTORY_SIZE> _snapshots;
+    uint32_t _latestSequence;
+};
+
+// Fills the created/updated/destroyed lists of delta with what changed from base to current (both sorted by id)
+void diffSnapshots(const std::vector<EntityState> &base, const std::vector<EntityState> &current,
+                   DeltaStateUpdateMessage &delta);
+
+// Rebuilds into result the snapshot the client gets by applying delta on base, the same way the client does
+void applyDelta(const std::vector<EntityState> &base, const DeltaStateUpdateMessage &delta,
+                std::vector<EntityState> &result);
+
+// Copies into packed the most important part of delta that fits in budget bytes: destroyed entities, players, then
+// the other entities closest to the client's player. What is left out is still in the next deltas.
+void packDelta(const DeltaStateUpdateMessage &delta, const std::vector<EntityState> &current, uint32_t clientId,
+               size_t budget, DeltaStateUpdateMessage &packed);
+
+}  // namespace server
+
+#endif  // SNAPSHOT_HISTORY_HPP
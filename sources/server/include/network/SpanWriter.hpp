@@ -0,0 +1,36 @@
+#ifndef SPAN_WRITER_HPP
+#define SPAN_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace server
+{
+
+// Writes bytes into a buffer the caller owns (e.g. a pooled send buffer), never allocates.
+// The serialize functions know the final size of what they write, going past the end of the buffer is a bug: it
+// throws std::runtime_error.
+class SpanWriter
+{
+  public:
+    SpanWriter(std::span<uint8_t> buffer);
+    ~SpanWriter();
+
+    void writeByte(uint8_t value);
+    void writeBytes(const void *data, size_t size);
+    // Raw bytes of value, already in network order
+    template <typename T> void write(const T &value) { writeBytes(&value, sizeof(T)); }
+
+    uint8_t *data();      // Start of the buffer, to patch what was already written
+    size_t size() const;  // Bytes written
+    size_t capacity() const;
+
+  private:
+    std::span<uint8_t> _buffer;
+    size_t _size;
+};
+
+}  // namespace server
+
+#endif  // SPAN_WRITER_HPP
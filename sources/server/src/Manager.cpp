@@ -1,14 +1,19 @@
 #include "Manager.hpp"
 
 #include <cstdint>
+#include <utility>
 
 using namespace server;
 
 void Manager::setGameOverStatus(bool isOver, GameOverType type)
 {
-    std::lock_guard<std::mutex> lock(_gameOverMutex);
-    _isGameOver = isOver;
-    _gameOverType = type;
+    {
+        std::lock_guard<std::mutex> lock(_gameOverMutex);
+        _isGameOver = isOver;
+        _gameOverType = type;
+    }
+    if (_outputCallback)
+        _outputCallback();
 }
 
 std::pair<bool, GameOverType> Manager::getGameOverStatus()
@@ -18,38 +23,44 @@ std::pair<bool, GameOverType> Manager::getGameOverStatus()
     return std::make_pair(_isGameOver, _gameOverType);
 }
 
-void Manager::pushInput(const UserInputMessage &msg)
+bool Manager::pushInput(const UserInputMessage &msg)
 {
-    std::lock_guard<std::mutex> lock(_inputMutex);
-    _inputQueue.push(msg);
-    _inputCV.notify_one();
+    return _inputRing.push(msg);
 }
 
 bool Manager::popInput(UserInputMessage &msg)
 {
-    std::lock_guard<std::mutex> lock(_inputMutex);
-    if (_inputQueue.empty())
-        return false;
-    msg = _inputQueue.front();
-    _inputQueue.pop();
-    return true;
+    return _inputRing.pop(msg);
 }
 
-void Manager::pushStateUpdate(const StateUpdateMessage &msg)
+bool Manager::popStateUpdate(StateUpdateMessage &msg)
 {
-    std::lock_guard<std::mutex> lock(_stateMutex);
-    _stateQueue.push(msg);
-    _stateCV.notify_one();
+    return _stateRing.pop(msg);
 }
 
-bool Manager::popStateUpdate(StateUpdateMessage &msg)
+void Manager::setOutputCallback(OutputCallback callback)
+{
+    _outputCallback = std::move(callback);
+}
+
+uint64_t Manager::inputOverflows() const
+{
+    return _inputRing.overflows();
+}
+
+uint64_t Manager::stateOverflows() const
+{
+    return _stateRing.overflows();
+}
+
+void Manager::countDroppedCommands(uint64_t count)
 {
-    std::lock_guard<std::mutex> lock(_stateMutex);
-    if (_stateQueue.empty())
-        return false;
-    msg = _stateQueue.front();
-    _stateQueue.pop();
-    return true;
+    _droppedCommands.fetch_add(count, std::memory_order_relaxed);
+}
+
+uint64_t Manager::droppedCommands() const
+{
+    return _droppedCommands.load(std::memory_order_relaxed);
 }
 
 void Manager::addClient(uint32_t clientId, const asio::ip::udp::endpoint &endpoint)
@@ -65,8 +76,13 @@ void Manager::removeClient(uint32_t clientId)
         _clients.erase(clientId);
     }
     {
-        std::lock_guard<std::mutex> lock(_entityMapMutex);
-        _clientToEntityMap.erase(clientId);
+        std::scoped_lock lock(_entityMapMutex, _clientIdMapMutex);
+        auto player = _clientToEntityMap.find(clientId);
+        if (player != _clientToEntityMap.end())
+        {
+            _entityIdToClientId.erase(player->second._id);
+            _clientToEntityMap.erase(player);
+        }
     }
 }
 
@@ -84,9 +100,13 @@ Registry &Manager::getRegistry()
 
 void Manager::mapClientToEntity(uint32_t clientId, Entity entity)
 {
-    std::lock_guard<std::mutex> lock(_entityMapMutex);
+    std::scoped_lock lock(_entityMapMutex, _clientIdMapMutex);
+    auto previous = _clientToEntityMap.find(clientId);
+    // The client's previous player no longer maps back to it
+    if (previous != _clientToEntityMap.end())
+        _entityIdToClientId.erase(previous->second._id);
     _clientToEntityMap[clientId] = entity;  // Now works because 'Entity' is default-constructible
-    _entityIdToClientId[entity._id] = clientId;
+    _entityIdToClientId[entity._id] = {entity, clientId};
 }
 
 bool Manager::hasEntityForClient(uint32_t clientId)
@@ -103,18 +123,18 @@ Entity Manager::getEntityForClient(uint32_t clientId)
     {
         return it->second;
     }
-    // return ivnalid entity
-    return Entity(0);
+    // Not a live handle, is_alive() is false for it
+    return Entity();
 }
 
-uint32_t Manager::getClientIdForEntityId(size_t entityId)
+uint32_t Manager::getClientIdForEntity(Entity entity)
 {
     std::lock_guard<std::mutex> lock(_clientIdMapMutex);  // ensure entityMapMutex is not const
-    auto it = _entityIdToClientId.find(entityId);
-    if (it != _entityIdToClientId.end())
+    auto it = _entityIdToClientId.find(entity._id);
+    // Same id but another generation: the player died and its id went to a new entity
+    if (it != _entityIdToClientId.end() && it->second.first.generation() == entity.generation())
     {
-        return it->second;
+        return it->second.second;
     }
-    // return ivnalid entity -> 42 not client
-    return 42;
+    return NO_CLIENT_ID;
 }
@@ -0,0 +1,95 @@
+#include "Room.hpp"
+
+#include "BossLevelScene.hpp"
+#include "EntityUtils.hpp"
+#include "FirstLevelScene.hpp"
+#include "LobbyScene.hpp"
+#include "SecondLevelScene.hpp"
+#include "ThirdLevelScene.hpp"
+
+#include <memory>
+
+using namespace server;
+
+Room::Room(uint32_t id, ThreadPool *pool) : _id(id), _manager(), _sceneManager(_manager), _sceneIdx(0)
+{
+    _manager.getRegistry().set_thread_pool(pool);
+    reserveProjectiles(_manager.getRegistry());
+
+    // Create scenes and add them to the scene manager
+    _sceneManager.addScene(std::make_unique<LobbyScene>(_manager));
+    _sceneManager.addScene(std::make_unique<FirstLevelScene>(_manager));
+    _sceneManager.addScene(std::make_unique<SecondLevelScene>(_manager));
+    _sceneManager.addScene(std::make_unique<ThirdLevelScene>(_manager));
+    _sceneManager.addScene(std::make_unique<BossLevelScene>(_manager));
+
+    // mapped to enter scene??
+    _sceneManager.atScene(0);
+    _sceneStartTime = std::chrono::high_resolution_clock::now();
+}
+
+Room::~Room() {}
+
+bool Room::tick(float dt)
+{
+    if (_over)
+        return false;
+
+    if (_sceneIdx != _sceneManager.currentSceneIdx())
+        _sceneStartTime = std::chrono::high_resolution_clock::now();
+
+    // mapped to scene update func
+    _sceneManager.update(_sceneStartTime, dt);
+
+    _sceneIdx = _sceneManager.currentSceneIdx();
+    _inLobby = (_sceneIdx == 0);
+
+    if (!checkGameOver())
+        return true;
+
+    _overSince = std::chrono::steady_clock::now().time_since_epoch().count();
+    _over = true;
+    return false;
+}
+
+bool Room::checkGameOver()
+{
+    if (_sceneManager.currentSceneIdx() == _sceneManager.size())
+    {
+        // send win game over
+        // funcion manager to send the state to the server
+        _manager.setGameOverStatus(true, GameOverType::Win);
+        return true;
+    } else if (_sceneManager.currentSceneIdx() != 0 && countPlayers(_manager.getRegistry()) == 0)
+    {
+        // send lose game over
+        _manager.setGameOverStatus(true, GameOverType::Lose);
+        return true;
+    }
+    return false;
+}
+
+uint32_t Room::id() const
+{
+    return _id;
+}
+
+Manager &Room::getManager()
+{
+    return _manager;
+}
+
+bool Room::inLobby() const
+{
+    return _inLobby;
+}
+
+bool Room::isOver() const
+{
+    return _over;
+}
+
+std::chrono::steady_clock::time_point Room::overSince() const
+{
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(_overSince.load()));
+}
@@ -0,0 +1,150 @@
+#include "RoomManager.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace server;
+
+RoomManager::RoomManager(ThreadPool *pool, size_t maxRooms) : _pool(pool), _maxRooms(maxRooms), _nextRoomId(1) {}
+
+RoomManager::~RoomManager() {}
+
+std::shared_ptr<Room> RoomManager::join(uint32_t clientId)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto seated = _clientRooms.find(clientId);
+    if (seated != _clientRooms.end())
+    {
+        if (!seated->second->isOver())
+            return seated->second;
+        // Connecting again after a game over: a new match
+        unseat(clientId);
+    }
+
+    auto seats = std::find_if(_rooms.begin(), _rooms.end(), [](const Seats &seats) {
+        return seats.room->inLobby() && !seats.room->isOver() && seats.clients < MAX_PLAYERS_PER_ROOM;
+    });
+
+    if (seats == _rooms.end())
+    {
+        if (_rooms.size() >= _maxRooms)
+            return nullptr;
+
+        auto room = std::make_shared<Room>(_nextRoomId++, _pool);
+        if (_roomOpenedCallback)
+            _roomOpenedCallback(room);
+        _rooms.push_back({room, 0});
+        seats = _rooms.end() - 1;
+        std::cout << "Room " << room->id() << " opened (" << _rooms.size() << " rooms)" << std::endl;
+    }
+
+    ++seats->clients;
+    _clientRooms[clientId] = seats->room;
+    return seats->room;
+}
+
+std::shared_ptr<Room> RoomManager::leave(uint32_t clientId)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return unseat(clientId);
+}
+
+std::shared_ptr<Room> RoomManager::unseat(uint32_t clientId)
+{
+    auto seated = _clientRooms.find(clientId);
+    if (seated == _clientRooms.end())
+        return nullptr;
+
+    std::shared_ptr<Room> room = std::move(seated->second);
+    _clientRooms.erase(seated);
+
+    auto seats = std::find_if(_rooms.begin(), _rooms.end(), [&room](const Seats &seats) { return seats.room == room; });
+    if (seats != _rooms.end())
+        --seats->clients;
+    return room;
+}
+
+std::shared_ptr<Room> RoomManager::find(uint32_t clientId) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto seated = _clientRooms.find(clientId);
+    return (seated != _clientRooms.end()) ? seated->second : nullptr;
+}
+
+void RoomManager::rooms(std::vector<std::shared_ptr<Room>> &rooms) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    rooms.clear();
+    for (const auto &seats : _rooms)
+    {
+        rooms.push_back(seats.room);
+    }
+}
+
+size_t RoomManager::closeRooms()
+{
+    std::vector<std::shared_ptr<Room>> closed;
+    RoomCallback closedCallback;
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        closedCallback = _roomClosedCallback;
+
+        auto closing = std::stable_partition(_rooms.begin(), _rooms.end(), [now](const Seats &seats) {
+            bool finished = seats.room->isOver() &&
+                            now - seats.room->overSince() >= std::chrono::milliseconds(ROOM_CLOSE_DELAY_MS);
+            return seats.clients > 0 && !finished;
+        });
+
+        for (auto seats = closing; seats != _rooms.end(); ++seats)
+        {
+            closed.push_back(seats->room);
+        }
+        _rooms.erase(closing, _rooms.end());
+
+        // Clients still seated in a finished room get a new one if they connect again
+        for (auto seated = _clientRooms.begin(); seated != _clientRooms.end();)
+        {
+            if (std::find(closed.begin(), closed.end(), seated->second) != closed.end())
+                seated = _clientRooms.erase(seated);
+            else
+                ++seated;
+        }
+    }
+
+    for (const auto &room : closed)
+    {
+        std::cout << "Room " << room->id() << " closed, dropped messages, inputs: "
+                  << room->getManager().inputOverflows() << ", state updates: " << room->getManager().stateOverflows()
+                  << ", input commands over budget: " << room->getManager().droppedCommands() << std::endl;
+        if (closedCallback)
+            closedCallback(room);
+    }
+    return closed.size();
+}
+
+size_t RoomManager::roomCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _rooms.size();
+}
+
+void RoomManager::setRoomOpenedCallback(RoomCallback callback)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _roomOpenedCallback = std::move(callback);
+}
+
+void RoomManager::setRoomClosedCallback(RoomCallback callback)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _roomClosedCallback = std::move(callback);
+}
@@ -1,81 +1,46 @@
 #include "Server.hpp"
 
-#include "BossLevelScene.hpp"
-#include "EntityUtils.hpp"
 #include "ExtendedNetwork.hpp"
-#include "FirstLevelScene.hpp"
-#include "LobbyScene.hpp"
-#include "Manager.hpp"
-#include "SceneManager.hpp"
-#include "SecondLevelScene.hpp"
+#include "RoomManager.hpp"
 #include "Server.hpp"
-#include "ThirdLevelScene.hpp"
+#include "ThreadPool.hpp"
+#include "TickScheduler.hpp"
 
+#include <algorithm>
 #include <asio.hpp>
 #include <cstddef>
 #include <iostream>
 #include <memory>
 #include <thread>
+#include <vector>
 
 using namespace server;
 
-Server::Server(unsigned short port) : _port(port) {}
-Server::~Server() {}
-
-bool gameOver(Manager &manager, SceneManager &sceneManager)
+Server::Server(unsigned short port, unsigned int tickRate, unsigned int workerThreads)
+    : _port(port), _tickRate(tickRate), _workerThreads(workerThreads)
 {
-    if (sceneManager.currentSceneIdx() == sceneManager.size())
-    {
-        // send win game over
-        // funcion manager to send the state to the server
-        manager.setGameOverStatus(true, GameOverType::Win);
-        return true;
-    } else if (sceneManager.currentSceneIdx() != 0 && countPlayers(manager.getRegistry()) == 0)
-    {
-        // send lose game over
-        manager.setGameOverStatus(true, GameOverType::Lose);
-        return true;
-    }
-    return false;
+    if (_workerThreads == 0)
+        _workerThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
 }
+Server::~Server() {}
 
-void gameLoop(Manager &manager)
+// Ticks every open room, the rooms are independent so they are spread over the pool.
+// Each room also runs its non conflicting systems on the same pool, so idle workers help the busiest rooms
+void gameLoop(RoomManager &rooms, ThreadPool &pool, unsigned int tickRate)
 {
-    size_t sceneIdx = 0;
-    SceneManager sceneManager(manager);
-
-    // Create scenes and add them to the scene manager
-    std::unique_ptr<LobbyScene> lobbyScene = std::make_unique<LobbyScene>(manager);
-    std::unique_ptr<FirstLevelScene> firstLevelScene = std::make_unique<FirstLevelScene>(manager);
-    std::unique_ptr<SecondLevelScene> secondLevelScene = std::make_unique<SecondLevelScene>(manager);
-    std::unique_ptr<ThirdLevelScene> thirdLevelScene = std::make_unique<ThirdLevelScene>(manager);
-    std::unique_ptr<BossLevelScene> bossLevelScene = std::make_unique<BossLevelScene>(manager);
+    TickScheduler scheduler(tickRate);
+    std::vector<std::shared_ptr<Room>> active;
 
-    sceneManager.addScene(std::move(lobbyScene));
-    sceneManager.addScene(std::move(firstLevelScene));
-    sceneManager.addScene(std::move(secondLevelScene));
-    sceneManager.addScene(std::move(thirdLevelScene));
-    sceneManager.addScene(std::move(bossLevelScene));
+    scheduler.run([&](float dt) {
+        rooms.rooms(active);
+        pool.run(active.size(), [&active, dt](size_t i) { active[i]->tick(dt); });
 
-    // mapped to enter scene??
-    sceneManager.atScene(0);
-
-    auto scenetStartTime = std::chrono::high_resolution_clock::now();
-
-    while (true)
-    {
-        if (sceneIdx != sceneManager.currentSceneIdx())
-            scenetStartTime = std::chrono::high_resolution_clock::now();
-
-        // mapped to scene update func
-        sceneManager.update(scenetStartTime);
-
-        sceneIdx = sceneManager.currentSceneIdx();
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / 60));
-
-        if (gameOver(manager, sceneManager))
-            break;
-    }
+        if (rooms.closeRooms() > 0)
+            std::cout << "Game loop at " << scheduler.tickRate() << " Hz on " << pool.threads() << " threads ("
+                      << scheduler.stats() << ")" << std::endl;
+        // Rooms are opened and closed as clients come and go, the loop runs as long as the server does
+        return true;
+    });
 }
 
 void Server::run()
@@ -84,23 +49,27 @@ void Server::run()
     {
         asio::io_context io_context;
 
-        // Create the Manager
-        Manager manager;
+        // Shared by the rooms and their systems, outlives them
+        ThreadPool pool(_workerThreads);
+
+        // Matches are created on demand as clients connect
+        RoomManager rooms(&pool);
 
         // Start the Extended Network Server
-        ExtendedNetworkServer server(io_context, _port, manager);
+        ExtendedNetworkServer server(io_context, _port, rooms);
         server.start();
 
         // Run the network logic in a separate thread
         std::thread serverThread([&io_context]() { io_context.run(); });
 
         // Run the ECS system in another thread -> have the ecsLoop
-        std::thread ecsThread([&manager]() { gameLoop(manager); });
+        std::thread ecsThread([this, &rooms, &pool]() { gameLoop(rooms, pool, _tickRate); });
 
         // At this point, the server is running and the ECS loop is running.
         // The main thread doesn't simulate a client anymore; it just waits.
 
-        std::cout << "Server is running on port " << _port << ". Press Ctrl+C to stop." << std::endl;
+        std::cout << "Server is running on port " << _port << " at " << _tickRate << " ticks per second with "
+                  << _workerThreads << " worker threads. Press Ctrl+C to stop." << std::endl;
 
         // Wait indefinitely until process is terminated
         // Alternatively, you could implement a command loop or a signal handler for a clean shutdown.
@@ -0,0 +1,88 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+using namespace server;
+
+ThreadPool::ThreadPool(size_t workers)
+{
+    _workers.reserve(workers);
+    for (size_t i = 0; i < workers; ++i)
+    {
+        _workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(size_t count, const Task &task)
+{
+    if (count == 0)
+        return;
+
+    // Not worth waking anyone up
+    if (_workers.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    Batch batch {&task, count, 0, count, {}};
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _batches.push_back(&batch);
+    _wake.notify_all();
+
+    while (batch.next < batch.count)
+        runOne(lock, batch);
+
+    // The last tasks may still be running on workers
+    batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+}
+
+size_t ThreadPool::threads() const
+{
+    return _workers.size() + 1;
+}
+
+void ThreadPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true)
+    {
+        _wake.wait(lock, [this]() { return _stopping || !_batches.empty(); });
+        if (_stopping)
+            return;
+        runOne(lock, *_batches.front());
+    }
+}
+
+void ThreadPool::runOne(std::unique_lock<std::mutex> &lock, Batch &batch)
+{
+    size_t index = batch.next++;
+
+    // Every task is picked, nobody else needs to find this batch
+    if (batch.next == batch.count)
+        _batches.erase(std::find(_batches.begin(), _batches.end(), &batch));
+
+    lock.unlock();
+    (*batch.task)(index);
+    lock.lock();
+
+    // The batch may be destroyed by its caller as soon as the lock is released
+    if (--batch.remaining == 0)
+        batch.done.notify_all();
+}
@@ -0,0 +1,85 @@
+#include "TickScheduler.hpp"
+
+#include <algorithm>
+#include <thread>
+
+using namespace server;
+
+TickScheduler::TickScheduler(unsigned int tickRate, unsigned int maxCatchUpTicks)
+    : _tickRate(std::max(tickRate, 1u)), _maxCatchUpTicks(std::max(maxCatchUpTicks, 1u)),
+      _period(std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / _tickRate))),
+      _dt(1.0f / static_cast<float>(_tickRate)), _stats()
+{}
+
+TickScheduler::~TickScheduler() {}
+
+void TickScheduler::run(const TickFunction &tick)
+{
+    clock::time_point deadline = clock::now();
+
+    while (true)
+    {
+        std::this_thread::sleep_until(deadline);
+
+        // Run every tick that is due, at most _maxCatchUpTicks of them
+        unsigned int dueTicks = 0;
+        while (clock::now() >= deadline && dueTicks < _maxCatchUpTicks)
+        {
+            clock::time_point tickStart = clock::now();
+            bool keepRunning = tick(_dt);
+            clock::duration tickLength = clock::now() - tickStart;
+
+            ++_stats.ticks;
+            if (dueTicks > 0)
+                ++_stats.catchUpTicks;
+            if (tickLength > _period)
+                ++_stats.overruns;
+            _stats.worstTick = std::max(_stats.worstTick, tickLength);
+
+            deadline += _period;
+            ++dueTicks;
+
+            if (!keepRunning)
+                return;
+        }
+
+        // Still late after the cap: drop the backlog, the next deadline is the first one still ahead of us
+        clock::time_point now = clock::now();
+        if (now >= deadline)
+        {
+            auto missedTicks = ((now - deadline) / _period) + 1;
+
+            _stats.droppedTicks += static_cast<uint64_t>(missedTicks);
+            deadline += missedTicks * _period;
+        }
+    }
+}
+
+unsigned int TickScheduler::tickRate() const
+{
+    return _tickRate;
+}
+
+float TickScheduler::dt() const
+{
+    return _dt;
+}
+
+TickScheduler::clock::duration TickScheduler::period() const
+{
+    return _period;
+}
+
+const TickScheduler::Stats &TickScheduler::stats() const
+{
+    return _stats;
+}
+
+std::ostream &server::operator<<(std::ostream &os, const TickScheduler::Stats &stats)
+{
+    auto worstTick = std::chrono::duration_cast<std::chrono::microseconds>(stats.worstTick);
+
+    return os << "ticks: " << stats.ticks << ", catch up: " << stats.catchUpTicks
+              << ", dropped: " << stats.droppedTicks << ", overruns: " << stats.overruns
+              << ", worst tick: " << worstTick.count() << "us";
+}
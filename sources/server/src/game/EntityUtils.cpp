@@ -1,10 +1,16 @@
 #include "EntityUtils.hpp"
 
 #include "Entity.hpp"
+#include "FireCooldownComponent.hpp"
+#include "InputComponent.hpp"
 #include "Manager.hpp"
 #include "PositionComponent.hpp"
+#include "Prefab.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <ostream>
 #include <utility>
@@ -12,8 +18,19 @@
 
 using namespace server;
 
+namespace
+{
+
+using MovingEntityPrefab = Prefab<PositionComponent, VelocityComponent, HealthComponent, EntityTypeComponent>;
+
+// Entities spawned in bursts, createBullet/createOrb override the position (and velocity)
+const MovingEntityPrefab BULLET_PREFAB({0.0f, 0.0f}, {600.0f, 0.0f}, {1}, {EntityType::BULLET});
+const MovingEntityPrefab ORB_PREFAB({0.0f, 0.0f}, {0.0f, 0.0f}, {1}, {EntityType::ORB});
+
+}  // namespace
+
 VelocityComponent server::calculateOrbVelocity(PositionComponent hitPosition, PositionComponent orbSpawnPoint,
-                                               float orbSpeed, int fps)
+                                               float orbSpeed)
 {
     // Direction vector
     float direction_x = hitPosition.x - orbSpawnPoint.x;
@@ -26,12 +43,9 @@ VelocityComponent server::calculateOrbVelocity(PositionComponent hitPosition, Po
     float normalized_x = direction_x / magnitude;
     float normalized_y = direction_y / magnitude;
 
-    // Distance per frame
-    float distance_per_frame = orbSpeed / fps;
-
-    // Velocity components
-    float velocity_x = normalized_x * distance_per_frame;
-    float velocity_y = normalized_y * distance_per_frame;
+    // Velocity components, the tick length is applied by position_system
+    float velocity_x = normalized_x * orbSpeed;
+    float velocity_y = normalized_y * orbSpeed;
 
     return {velocity_x, velocity_y};
 }
@@ -48,23 +62,22 @@ void server::restartPlayerPositions(Manager &manager)
 
     for (const auto &client : clientMap)
     {
-        if (manager.hasEntityForClient(client.first))
-        {
-            Entity player = manager.getEntityForClient(client.first);
+        Entity player = manager.getEntityForClient(client.first);
+        // A dead player's id may already belong to another entity
+        if (manager.hasEntityForClient(client.first) && manager.getRegistry().is_alive(player))
             players.push_back(player);
-        }
     }
 
+    auto &posArray = manager.getRegistry().get_components<PositionComponent>();
     for (const auto &player : players)
     {
-        auto &posArray = manager.getRegistry().get_components<PositionComponent>();
-        auto &posOpt = posArray[player];
+        PositionComponent *pos = posArray.find(player);
 
-        if (posOpt.has_value())
+        if (pos != nullptr)
         {
             // Place players separated by 100 units in the y-axis + wrap around the world
-            posOpt->x = 100.0f;
-            posOpt->y = 100.0f + (i * 100.0f);
+            pos->x = 100.0f;
+            pos->y = 100.0f + (i * 100.0f);
         }
         i++;
     }
@@ -75,11 +88,11 @@ int server::countPlayers(Registry &registry)
     try
     {
         int count = 0;
-        auto entities = registry.get_components<EntityTypeComponent>();
+        auto &types = registry.get_components<EntityTypeComponent>();
 
-        for (const auto &entity : entities)
+        for (const auto &type : types)
         {
-            if (entity.has_value() && entity->type == EntityType::PLAYER)
+            if (type.type == EntityType::PLAYER)
                 count++;
         }
         return count;
@@ -92,13 +105,14 @@ int server::countPlayers(Registry &registry)
 
 void server::killAllEntitiesButPlayers(Registry &registry)
 {
-    auto entities = registry.get_components<EntityTypeComponent>();
+    auto &types = registry.get_components<EntityTypeComponent>();
 
-    for (size_t i = 0; i < entities.size(); ++i)
+    // Backwards, killing swaps the last (already visited) type into the freed slot
+    for (size_t n = types.size(); n-- > 0;)
     {
-        if (entities[i].has_value() && entities[i]->type != EntityType::PLAYER)
+        if (types.value_at(n).type != EntityType::PLAYER)
         {
-            registry.kill_entity(static_cast<Entity>(i));
+            registry.kill_entity(registry.entity_at(types.id_at(n)));
         }
     }
 }
@@ -106,11 +120,11 @@ void server::killAllEntitiesButPlayers(Registry &registry)
 bool server::mobsAlive(Registry &registry)
 {
     bool mobsAlive = false;
-    auto aliveEntityTypes = registry.get_components<EntityTypeComponent>();
+    auto &aliveEntityTypes = registry.get_components<EntityTypeComponent>();
 
     for (const auto &type : aliveEntityTypes)
     {
-        if (type.has_value() && type->type == EntityType::MOB)
+        if (type.type == EntityType::MOB)
         {
             mobsAlive = true;
             break;
@@ -135,7 +149,7 @@ int countBullets(Registry &registry)
 
     for (const auto &type : typeArray)
     {
-        if (type.has_value() && type->type == EntityType::BULLET)
+        if (type.type == EntityType::BULLET)
         {
             bulletCount++;
         }
@@ -153,6 +167,8 @@ Entity server::createPlayer(Manager &manager, uint32_t clientId, PositionCompone
     registry.add_component<VelocityComponent>(player, std::move(vel));
     registry.add_component<HealthComponent>(player, std::move(hp));
     registry.add_component<EntityTypeComponent>(player, {EntityType::PLAYER});
+    registry.add_component<InputComponent>(player, {0, PLAYER_INPUT_BURST});
+    registry.add_component<FireCooldownComponent>(player, {PLAYER_FIRE_COOLDOWN, 0.0f});
 
     manager.mapClientToEntity(clientId, player);
     return player;
@@ -183,144 +199,175 @@ Entity server::createMob(Registry &registry, PositionComponent pos = {100.0f, 10
     return mob;
 }
 
-Entity server::createBullet(Registry &registry, PositionComponent pos)
+Entity server::createBullet(CommandBuffer &commands, PositionComponent pos)
 {
-    Entity bullet = registry.spawn_entity();
-
-    registry.add_component<PositionComponent>(bullet, {pos.x, pos.y + 18.0f});
-    registry.add_component<VelocityComponent>(bullet, {10.0f, 0.0f});
-    registry.add_component<HealthComponent>(bullet, {1});
-    registry.add_component<EntityTypeComponent>(bullet, {EntityType::BULLET});
-
-    return bullet;
+    return BULLET_PREFAB.spawn(commands, PositionComponent {pos.x, pos.y + 18.0f});
 }
 
 Entity server::createOrb(Registry &registry, PositionComponent pos, VelocityComponent vel)
 {
-    Entity orb = registry.spawn_entity();
+    return ORB_PREFAB.spawn(registry, PositionComponent {pos.x, pos.y + 18.0f}, vel);
+}
 
-    registry.add_component<PositionComponent>(orb, {pos.x, pos.y + 18.0f});
-    registry.add_component<VelocityComponent>(orb, {vel.vx, vel.vy});
-    registry.add_component<HealthComponent>(orb, {1});
-    registry.add_component<EntityTypeComponent>(orb, {EntityType::ORB});
+void server::reserveProjectiles(Registry &registry)
+{
+    // Both prefabs have the same components, the arrays are sized for all of them at once
+    BULLET_PREFAB.reserve(registry, MAX_BULLETS + MAX_ORBS);
+}
 
-    return orb;
+void server::removeDepartedPlayers(Manager &manager)
+{
+    Registry &registry = manager.getRegistry();
+    std::vector<Entity> departed;
+
+    // removeClient unmapped their entity. Killed once the view is done, the lobby never flushes the command buffer
+    for (auto &&[i, type] : registry.view<EntityTypeComponent>())
+    {
+        Entity entity = registry.entity_at(i);
+        if (type.type == EntityType::PLAYER && manager.getClientIdForEntity(entity) == NO_CLIENT_ID)
+            departed.push_back(entity);
+    }
+    for (const Entity &entity : departed)
+    {
+        std::cout << "Removing the player of a departed client, entity " << entity._id << std::endl;
+        registry.kill_entity(entity);
+    }
 }
 
 void server::processUserInput(Manager &manager,
-                              const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime)
+                              const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
+                              float dt)
 {
+    Registry &registry = manager.getRegistry();
+    auto &inputs = registry.get_components<InputComponent>();
     UserInputMessage inputMsg;
-    static auto lastBulletTime = std::chrono::high_resolution_clock::now();
 
+    removeDepartedPlayers(manager);
+
+    // Coalesced per player: every message of the tick only adds its commands to the player's input
     while (manager.popInput(inputMsg))
     {
         std::cout << "ECS received input from Client ID: " << inputMsg.clientId
                   << " with flags: " << static_cast<int>(inputMsg.inputFlags) << std::endl;
 
-        if (manager.hasEntityForClient(inputMsg.clientId))
+        if (!manager.hasEntityForClient(inputMsg.clientId))
+            continue;
+        Entity playerEnt = manager.getEntityForClient(inputMsg.clientId);
+
+        // Dead player, its id may already belong to another entity
+        InputComponent *input = inputs.find(playerEnt);
+        if (!registry.is_alive(playerEnt) || input == nullptr)
+            continue;
+
+        // Lobby inputs have no sequence. A message also repeats the previous commands, in case their own message
+        // was lost: only the commands newer than the last one applied are, oldest first. Applying the older ones
+        // would move the player away from where the client predicted it.
+        std::array<uint8_t, INPUT_REDUNDANCY + 1> commands;
+        size_t count = 0;
+        if (inputMsg.sequence == 0)
         {
-            Entity playerEnt = manager.getEntityForClient(inputMsg.clientId);
-
-            bool moveUp = (inputMsg.inputFlags & static_cast<uint8_t>(InputFlags::MoveUp)) != 0;
-            bool moveDown = (inputMsg.inputFlags & static_cast<uint8_t>(InputFlags::MoveDown)) != 0;
-            bool moveLeft = (inputMsg.inputFlags & static_cast<uint8_t>(InputFlags::MoveLeft)) != 0;
-            bool moveRight = (inputMsg.inputFlags & static_cast<uint8_t>(InputFlags::MoveRight)) != 0;
-            bool fire = (inputMsg.inputFlags & static_cast<uint8_t>(InputFlags::Fire)) != 0;
-
-            const float stepSize = 10.0f;
-            auto &registry = manager.getRegistry();
-
-            // Directly update position based on inputs (no velocity component)
-            auto &posArray = registry.get_components<PositionComponent>();
-            auto &posOpt = posArray[playerEnt];  // posOpt is a reference to the optional in the array
-            if (posOpt.has_value())
+            commands[count++] = inputMsg.inputFlags;
+        } else
+        {
+            for (uint32_t i = INPUT_REDUNDANCY; i > 0; --i)
             {
-                if (moveUp)
-                    posOpt->y -= stepSize;
-                if (moveDown)
-                    posOpt->y += stepSize;
-                if (moveLeft)
-                    posOpt->x -= stepSize * 2;
-                if (moveRight)
-                    posOpt->x += stepSize * 2;
+                if (i < inputMsg.sequence && inputMsg.sequence - i > input->sequence)
+                    commands[count++] = inputMsg.previousFlags[i - 1];
             }
+            if (inputMsg.sequence > input->sequence)
+                commands[count++] = inputMsg.inputFlags;
+            input->sequence = std::max(input->sequence, inputMsg.sequence);
+        }
 
-            auto now = std::chrono::high_resolution_clock::now();
-            auto timeSinceLastBullet =
-                std::chrono::duration_cast<std::chrono::milliseconds>(now - lastBulletTime).count();
+        // One step per command, within the budget. The sequence still moves past the commands over it: the ack
+        // brings the client's predicted player back to where the server has it.
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint8_t flags = commands[i];
 
-            if (fire && timeSinceLastBullet >= 500)  // 500 milliseconds = 0.5 seconds
+            if (input->budget < 1.0f)
             {
-                auto posOpt = registry.get_components<PositionComponent>()[playerEnt];
-                if (posOpt.has_value())
-                {
-                    createBullet(manager.getRegistry(), posOpt.value());
-                    lastBulletTime = now;  // Update the last bullet time
-                }
+                manager.countDroppedCommands(count - i);
+                break;
             }
+            input->budget -= 1.0f;
+            if (flags & static_cast<uint8_t>(InputFlags::MoveUp))
+                input->moveY -= PLAYER_STEP;
+            if (flags & static_cast<uint8_t>(InputFlags::MoveDown))
+                input->moveY += PLAYER_STEP;
+            if (flags & static_cast<uint8_t>(InputFlags::MoveLeft))
+                input->moveX -= PLAYER_STEP * 2;
+            if (flags & static_cast<uint8_t>(InputFlags::MoveRight))
+                input->moveX += PLAYER_STEP * 2;
+            input->fire = input->fire || (flags & static_cast<uint8_t>(InputFlags::Fire));
         }
     }
-}
-
-StateUpdateMessage server::processOutput(Manager &manager)
-{
-    StateUpdateMessage stateMsg;
-    std::vector<EntityState> entityStates;
 
-    auto &posArray = manager.getRegistry().get_components<PositionComponent>();
-    auto &velArray = manager.getRegistry().get_components<VelocityComponent>();
-    auto &healthArray = manager.getRegistry().get_components<HealthComponent>();
-    auto &typeArray = manager.getRegistry().get_components<EntityTypeComponent>();
-
-    stateMsg.header.messageType = static_cast<uint16_t>(MessageType::StateUpdate);
-    for (size_t i = 0; i < posArray.size(); ++i)
+    // Then each player applies its input once: the movement of its commands, and a shot when any of them fired and
+    // its own cooldown is over
+    for (auto &&[i, input, pos, cooldown] : registry.view<InputComponent, PositionComponent, FireCooldownComponent>())
     {
-        if (posArray[i].has_value())
+        // Directly update position based on inputs (no velocity component)
+        pos.x += input.moveX;
+        pos.y += input.moveY;
+
+        cooldown.remaining = std::max(0.0f, cooldown.remaining - dt);
+        if (input.fire && cooldown.remaining <= 0.0f)
         {
-            float px = posArray[i]->x;
-            float py = posArray[i]->y;
-            float vx = 0.0f;
-            float vy = 0.0f;
-            EntityType eType;
-            uint8_t hp = 0;
-
-            if (i < velArray.size() && velArray[i].has_value())
-            {
-                vx = velArray[i]->vx;
-                vy = velArray[i]->vy;
-            }
+            // Spawned with the other structural changes of the tick, once the systems ran
+            createBullet(registry.commands(), pos);
+            cooldown.remaining = cooldown.period;
+        }
 
-            if (i < typeArray.size() && typeArray[i].has_value())
-            {
-                eType = typeArray[i]->type;
-            }
+        // Ready for the next tick
+        input.budget = std::min(PLAYER_INPUT_BURST, input.budget + PLAYER_INPUT_RATE * dt);
+        input.moveX = 0.0f;
+        input.moveY = 0.0f;
+        input.fire = false;
+    }
+}
 
-            if (i < healthArray.size() && healthArray[i].has_value())
-            {
-                hp = static_cast<uint8_t>(healthArray[i]->value);
-            }
+void server::processOutput(Manager &manager, StateUpdateMessage &stateMsg)
+{
+    // stateMsg may hold an older update, clear() keeps the capacity of its vector
+    std::vector<EntityState> &entityStates = stateMsg.entities;
+    auto view =
+        manager.getRegistry().view<PositionComponent, VelocityComponent, EntityTypeComponent, HealthComponent>();
 
-            EntityState es;
-            es.clientId = manager.getClientIdForEntityId(i);
-            es.entityId = static_cast<uint32_t>(i);
-            es.posX = px;
-            es.posY = py;
-            es.velX = vx;
-            es.velY = vy;
-            es.entityType = eType;
-            es.health = hp;
-
-            entityStates.push_back(es);
-        }
+    stateMsg.header.messageType = static_cast<uint16_t>(MessageType::StateUpdate);
+    entityStates.clear();
+    entityStates.reserve(view.size_hint());
+    for (auto &&[i, pos, vel, type, health] : view)
+    {
+        EntityState es;
+        es.clientId = manager.getClientIdForEntity(manager.getRegistry().entity_at(i));
+        es.entityId = static_cast<uint32_t>(i);
+        es.posX = pos.x;
+        es.posY = pos.y;
+        es.velX = vel.vx;
+        es.velY = vel.vy;
+        es.entityType = type.type;
+        es.health = static_cast<uint8_t>(health.value);
+
+        entityStates.push_back(es);
     }
 
     stateMsg.numEntities = static_cast<uint32_t>(entityStates.size());
-    stateMsg.entities = std::move(entityStates);
-    stateMsg.header.messageSize =
-        sizeof(StateUpdateMessage) + static_cast<uint16_t>(stateMsg.entities.size() * sizeof(EntityState));
 
-    return stateMsg;
+    // Where each player is once its last command was applied, the client replays the newer ones from there
+    stateMsg.inputAcks.clear();
+    for (auto &&[i, input, pos] : manager.getRegistry().view<InputComponent, PositionComponent>())
+    {
+        if (input.sequence == 0)
+            continue;
+        stateMsg.inputAcks.push_back({
+            {static_cast<uint16_t>(MessageType::InputAck), sizeof(InputAckMessage)},
+            manager.getClientIdForEntity(manager.getRegistry().entity_at(i)), input.sequence, pos.x, pos.y
+        });
+    }
+    // Size on the wire (header, entity count, entities), saturated: the full state is only ever sent as deltas
+    size_t wireSize = sizeof(MessageHeader) + sizeof(uint32_t) + entityStates.size() * sizeof(EntityState);
+    stateMsg.header.messageSize = static_cast<uint16_t>(std::min<size_t>(wireSize, UINT16_MAX));
 }
 
 bool server::processStartGame(Manager &manager)
@@ -15,11 +15,11 @@ using namespace server;
 
 bool bossAlive(Registry &registry)
 {
-    auto aliveEntityTypes = registry.get_components<EntityTypeComponent>();
+    auto &aliveEntityTypes = registry.get_components<EntityTypeComponent>();
 
     for (const auto &type : aliveEntityTypes)
     {
-        if (type.has_value() && type->type == EntityType::BOSS)
+        if (type.type == EntityType::BOSS)
         {
             return true;
         }
@@ -27,19 +27,18 @@ bool bossAlive(Registry &registry)
     return false;
 }
 
-void bossAI(Manager &manager, const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime)
+void bossAI(Manager &manager, const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
+            std::chrono::time_point<std::chrono::high_resolution_clock> &lastOrbTime)
 {
     std::vector<Entity> players;
     auto clientMap = manager.getClients();
-    static auto lastOrbTime = std::chrono::high_resolution_clock::now();
 
     for (const auto &client : clientMap)
     {
-        if (manager.hasEntityForClient(client.first))
-        {
-            Entity player = manager.getEntityForClient(client.first);
+        Entity player = manager.getEntityForClient(client.first);
+        // A dead player's id may already belong to another entity
+        if (manager.hasEntityForClient(client.first) && manager.getRegistry().is_alive(player))
             players.push_back(player);
-        }
     }
 
     if (players.empty())
@@ -51,13 +50,14 @@ void bossAI(Manager &manager, const std::chrono::time_point<std::chrono::high_re
     std::uniform_int_distribution<int> dist(0, players.size() - 1);
     Entity random_player = players[dist(engine)];
 
-    auto optionalPlayerPosition = manager.getRegistry().get_components<PositionComponent>()[random_player];
-    if (!optionalPlayerPosition.has_value())
+    PositionComponent *optionalPlayerPosition =
+        manager.getRegistry().get_components<PositionComponent>().find(random_player);
+    if (optionalPlayerPosition == nullptr)
         return;
 
-    PositionComponent playerPosition = optionalPlayerPosition.value();
+    PositionComponent playerPosition = *optionalPlayerPosition;
 
-    VelocityComponent orbVelocity = calculateOrbVelocity(playerPosition, {1300, 500}, 500.0f, 60);
+    VelocityComponent orbVelocity = calculateOrbVelocity(playerPosition, {1300, 500}, 500.0f);
 
     auto now = std::chrono::high_resolution_clock::now();
     auto timeSinceLastOrb = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastOrbTime).count();
@@ -71,13 +71,16 @@ void bossAI(Manager &manager, const std::chrono::time_point<std::chrono::high_re
     }
 }
 
-BossLevelScene::BossLevelScene(Manager &manager) : AScene(manager) {}
+BossLevelScene::BossLevelScene(Manager &manager)
+    : AScene(manager), _lastOrbTime(std::chrono::high_resolution_clock::now())
+{}
 
 BossLevelScene::~BossLevelScene() {}
 
 void BossLevelScene::enter()
 {
     restartPlayerPositions(*_manager);
+    _lastOrbTime = std::chrono::high_resolution_clock::now();
 
     // Add boss
     createBoss(_manager->getRegistry(), {WORLD_MAX_WIDTH - 400, WORLD_MAX_HEIGHT / 2}, {0.0f, 0.0f}, {1000});
@@ -90,21 +93,21 @@ void BossLevelScene::exit()
 }
 
 void BossLevelScene::update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                            SceneEvent &event)
+                            SceneEvent &event, float dt)
 {
     // Update the BossLevelScene scene
-    processUserInput(*_manager, sceneStartTime);
+    processUserInput(*_manager, sceneStartTime, dt);
 
-    _manager->getRegistry().run_systems();
+    _manager->getRegistry().run_systems(dt);
 
     // Handle boss spawning orbs and shotting them at the player
-    bossAI(*_manager, sceneStartTime);
+    bossAI(*_manager, sceneStartTime, _lastOrbTime);
 
     // If boss is dead, next scene
     if (!bossAlive(_manager->getRegistry()))
     {
         event.event = Event::NEXT;
     }
-    StateUpdateMessage state = processOutput(*_manager);
-    _manager->pushStateUpdate(state);
+    // Build the state update straight into the manager ring
+    _manager->pushStateUpdate([this](StateUpdateMessage &state) { processOutput(*_manager, state); });
 }
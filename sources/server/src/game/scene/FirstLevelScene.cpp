@@ -15,22 +15,25 @@ FirstLevelScene::~FirstLevelScene() {}
 
 void FirstLevelScene::enter()
 {
-    // Add systems
-    _manager->getRegistry().add_system<PositionComponent, VelocityComponent>(position_system);
-    _manager->getRegistry().add_system<HealthComponent>(health_system);
-    _manager->getRegistry().add_system<PositionComponent, VelocityComponent, HealthComponent, EntityTypeComponent>(
-        collision_system);
-    _manager->getRegistry().add_system<PositionComponent, HealthComponent, EntityTypeComponent>(out_of_bounds_system);
-    _manager->getRegistry().add_system<PositionComponent, EntityTypeComponent>(position_wrapping_system);
+    // Add systems, with what they read and write so the ones that don't conflict run concurrently.
+    // The movement systems group their arrays (Registry::group), which reorders them: they write all of them
+    Registry &registry = _manager->getRegistry();
+    registry.add_system<Write<PositionComponent>, Write<VelocityComponent>>(position_system);
+    registry.add_system<Read<HealthComponent>, Entities>(health_system);
+    registry.add_system<Read<PositionComponent>, Read<VelocityComponent>, Write<HealthComponent>,
+                        Read<EntityTypeComponent>>(collision_system);
+    registry.add_system<Write<PositionComponent>, Write<HealthComponent>, Write<EntityTypeComponent>>(
+        out_of_bounds_system);
+    registry.add_system<Write<PositionComponent>, Write<EntityTypeComponent>>(position_wrapping_system);
 
     restartPlayerPositions(*_manager);
     // createMob(_manager->getRegistry(), {300.0f, 100.0f}, {0.0f, 0.0f}, {100});
 
     // Add entities
-    createMob(_manager->getRegistry(), {1100.0f, 700.0f}, {-0.50f, -1.0f}, {100});
-    createMob(_manager->getRegistry(), {1000.0f, 400.0f}, {-1.0f, 1.0f}, {100});
-    createMob(_manager->getRegistry(), {900.0f, 300.0f}, {0.1f, 1.50f}, {100});
-    createMob(_manager->getRegistry(), {1200.0f, 100.0f}, {0.2f, -1.50f}, {100});
+    createMob(_manager->getRegistry(), {1100.0f, 700.0f}, {-30.0f, -60.0f}, {100});
+    createMob(_manager->getRegistry(), {1000.0f, 400.0f}, {-60.0f, 60.0f}, {100});
+    createMob(_manager->getRegistry(), {900.0f, 300.0f}, {6.0f, 90.0f}, {100});
+    createMob(_manager->getRegistry(), {1200.0f, 100.0f}, {12.0f, -90.0f}, {100});
 }
 
 void FirstLevelScene::exit()
@@ -40,12 +43,12 @@ void FirstLevelScene::exit()
 }
 
 void FirstLevelScene::update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                             SceneEvent &event)
+                             SceneEvent &event, float dt)
 {
     // Update the FirstLevelScene scene
-    processUserInput(*_manager, sceneStartTime);
+    processUserInput(*_manager, sceneStartTime, dt);
 
-    _manager->getRegistry().run_systems();
+    _manager->getRegistry().run_systems(dt);
 
     // If no more enemies, next scene
     if (!mobsAlive(_manager->getRegistry()))
@@ -53,6 +56,6 @@ void FirstLevelScene::update(const std::chrono::time_point<std::chrono::high_res
         event.event = Event::NEXT;
     }
 
-    StateUpdateMessage state = processOutput(*_manager);
-    _manager->pushStateUpdate(state);
+    // Build the state update straight into the manager ring
+    _manager->pushStateUpdate([this](StateUpdateMessage &state) { processOutput(*_manager, state); });
 }
@@ -27,10 +27,12 @@ void LobbyScene::exit()
 }
 
 void LobbyScene::update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                        SceneEvent &event)
+                        SceneEvent &event, float /*dt*/)
 {
     // Update the lobby scene
     std::cout << "Updating lobby scene" << std::endl;
+    removeDepartedPlayers(_manager);
+
     auto clients = _manager.getClients();
     for (const auto &[clientId, endpoint] : clients)
     {
@@ -50,111 +52,27 @@ void LobbyScene::update(const std::chrono::time_point<std::chrono::high_resoluti
         return;  // or `continue;` if you're in a while-loop, etc.
     }
 
-    std::cout << "[ECS] Before catching entity entity:\n";
     // here state update to all clients connected
-    auto &posArray = _manager.getRegistry().get_components<PositionComponent>();
-    std::cout << "[ECS] After getting pos array:\n";
-    auto &velArray = _manager.getRegistry().get_components<VelocityComponent>();
-    std::cout << "[ECS] After getting vel array:\n";
-    auto &healthArray = _manager.getRegistry().get_components<HealthComponent>();
-    std::cout << "[ECS] After getting healt array:\n";
-    auto &typeArray = _manager.getRegistry().get_components<EntityTypeComponent>();
-    std::cout << "[ECS] After getting type array:\n";
+    auto view =
+        _manager.getRegistry().view<PositionComponent, VelocityComponent, EntityTypeComponent, HealthComponent>();
 
     // --------------------------- DEBUGGING ---------------------- //
     std::cout << "[ECS] Entity States After Update:\n";
-    for (size_t i = 0; i < posArray.size(); ++i)
+    for (auto &&[i, pos, vel, type, health] : view)
     {
-        if (posArray[i].has_value())
-        {
-            float px = posArray[i]->x;
-            float py = posArray[i]->y;
-
-            float vx = 0.0f;
-            float vy = 0.0f;
-            if (i < velArray.size() && velArray[i].has_value())
-            {
-                vx = velArray[i]->vx;
-                vy = velArray[i]->vy;
-            }
-
-            EntityType eType;
-            if (i < typeArray.size() && typeArray[i].has_value())
-            {
-                eType = typeArray[i]->type;
-            }
-
-            int hp = -1;
-            if (i < healthArray.size() && healthArray[i].has_value())
-            {
-                hp = healthArray[i]->value;
-            }
-
-            std::string entityType = (eType == EntityType::PLAYER)   ? "Player"
-                                     : (eType == EntityType::MOB)    ? "Mob"
-                                     : (eType == EntityType::BULLET) ? "Bullet"
+        std::string entityType = (type.type == EntityType::PLAYER)   ? "Player"
+                                 : (type.type == EntityType::MOB)    ? "Mob"
+                                 : (type.type == EntityType::BULLET) ? "Bullet"
                                                                      : "Unknown";
 
-            std::cout << "  Entity " << i << " Type:" << entityType << " Pos:(" << px << ", " << py << ")"
-                      << " Vel:(" << vx << ", " << vy << ")"
-                      << " HP:" << hp << "\n";
-        }
+        std::cout << "  Entity " << i << " Type:" << entityType << " Pos:(" << pos.x << ", " << pos.y << ")"
+                  << " Vel:(" << vel.vx << ", " << vel.vy << ")"
+                  << " HP:" << health.value << "\n";
     }
     // --------------------------- DEBUGGING ---------------------- //
 
-    // maybe encapsulate here -> but we will have only clients here -> no need to care about pos or so
-    // sended just to keep standart
-    StateUpdateMessage stateMsg;
-    stateMsg.header.messageType = static_cast<uint16_t>(MessageType::StateUpdate);
-
-    std::vector<EntityState> entityStates;
-    for (size_t i = 0; i < posArray.size(); ++i)
-    {
-        if (posArray[i].has_value())
-        {
-            float px = posArray[i]->x;
-            float py = posArray[i]->y;
-            float vx = 0.0f;
-            float vy = 0.0f;
-            EntityType eType;
-            uint8_t hp = 0;
-
-            if (i < velArray.size() && velArray[i].has_value())
-            {
-                vx = velArray[i]->vx;
-                vy = velArray[i]->vy;
-            }
-
-            if (i < typeArray.size() && typeArray[i].has_value())
-            {
-                eType = typeArray[i]->type;
-            }
-
-            if (i < healthArray.size() && healthArray[i].has_value())
-            {
-                hp = static_cast<uint8_t>(healthArray[i]->value);
-            }
-
-            EntityState es;
-            es.entityId = static_cast<uint32_t>(i);
-            es.clientId = _manager.getClientIdForEntityId(i);
-            es.posX = px;
-            es.posY = py;
-            es.velX = vx;
-            es.velY = vy;
-            es.entityType = eType;
-            es.health = hp;
-            entityStates.push_back(es);
-        }
-    }
-
-    stateMsg.numEntities = static_cast<uint32_t>(entityStates.size());
-    stateMsg.entities = std::move(entityStates);
-    stateMsg.header.messageSize =
-        sizeof(StateUpdateMessage) + static_cast<uint16_t>(stateMsg.entities.size() * sizeof(EntityState));
-
-    // to manager see when update
-    _manager.pushStateUpdate(stateMsg);
+    // to manager see when update, built straight into the manager ring
+    _manager.pushStateUpdate([this](StateUpdateMessage &stateMsg) { processOutput(_manager, stateMsg); });
 
     // read client input here
     bool start_game = processStartGame(_manager);
@@ -54,9 +54,10 @@ void SceneManager::atScene(size_t idx)
     _scenes[_currSceneIdx]->enter();
 }
 
-void SceneManager::update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime)
+void SceneManager::update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
+                          float dt)
 {
-    _scenes[_currSceneIdx]->update(sceneStartTime, _event);
+    _scenes[_currSceneIdx]->update(sceneStartTime, _event, dt);
 
     switch (_event.event)
     {
@@ -16,12 +16,12 @@ void SecondLevelScene::enter()
     restartPlayerPositions(*_manager);
 
     // Add entities
-    createMob(_manager->getRegistry(), {1000.0f, 50.0f}, {-4.0f, 0.0f}, {100});
-    createMob(_manager->getRegistry(), {1000.0f, 250.0f}, {-4.0f, 0.0f}, {100});
-    createMob(_manager->getRegistry(), {1000.0f, 450.0f}, {-4.0f, 0.0f}, {100});
-    createMob(_manager->getRegistry(), {1000.0f, 650.0f}, {-4.0f, 0.0f}, {100});
-    createMob(_manager->getRegistry(), {1000.0f, 850.0f}, {-4.0f, 0.0f}, {100});
-    createMob(_manager->getRegistry(), {1000.0f, 1050.0f}, {-4.0f, 0.0f}, {100});
+    createMob(_manager->getRegistry(), {1000.0f, 50.0f}, {-240.0f, 0.0f}, {100});
+    createMob(_manager->getRegistry(), {1000.0f, 250.0f}, {-240.0f, 0.0f}, {100});
+    createMob(_manager->getRegistry(), {1000.0f, 450.0f}, {-240.0f, 0.0f}, {100});
+    createMob(_manager->getRegistry(), {1000.0f, 650.0f}, {-240.0f, 0.0f}, {100});
+    createMob(_manager->getRegistry(), {1000.0f, 850.0f}, {-240.0f, 0.0f}, {100});
+    createMob(_manager->getRegistry(), {1000.0f, 1050.0f}, {-240.0f, 0.0f}, {100});
 }
 
 void SecondLevelScene::exit()
@@ -31,12 +31,12 @@ void SecondLevelScene::exit()
 }
 
 void SecondLevelScene::update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                              SceneEvent &event)
+                              SceneEvent &event, float dt)
 {
     // Update the SecondLevelScene scene
-    processUserInput(*_manager, sceneStartTime);
+    processUserInput(*_manager, sceneStartTime, dt);
 
-    _manager->getRegistry().run_systems();
+    _manager->getRegistry().run_systems(dt);
 
     // If no more enemies, next scene
     if (!mobsAlive(_manager->getRegistry()))
@@ -44,6 +44,6 @@ void SecondLevelScene::update(const std::chrono::time_point<std::chrono::high_re
         event.event = Event::NEXT;
     }
 
-    StateUpdateMessage state = processOutput(*_manager);
-    _manager->pushStateUpdate(state);
+    // Build the state update straight into the manager ring
+    _manager->pushStateUpdate([this](StateUpdateMessage &state) { processOutput(*_manager, state); });
 }
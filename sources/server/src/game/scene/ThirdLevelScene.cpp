@@ -12,19 +12,18 @@
 using namespace server;
 
 void thirdLvlMobsAI(Manager &manager, const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                    bool &firstMobAlive, bool &secondMobAlive)
+                    bool &firstMobAlive, bool &secondMobAlive,
+                    std::chrono::time_point<std::chrono::high_resolution_clock> &lastOrbTime)
 {
     std::vector<Entity> players;
     auto clientMap = manager.getClients();
-    static auto lastOrbTime = std::chrono::high_resolution_clock::now();
 
     for (const auto &client : clientMap)
     {
-        if (manager.hasEntityForClient(client.first))
-        {
-            Entity player = manager.getEntityForClient(client.first);
+        Entity player = manager.getEntityForClient(client.first);
+        // A dead player's id may already belong to another entity
+        if (manager.hasEntityForClient(client.first) && manager.getRegistry().is_alive(player))
             players.push_back(player);
-        }
     }
 
     if (players.empty())
@@ -36,17 +35,18 @@ void thirdLvlMobsAI(Manager &manager, const std::chrono::time_point<std::chrono:
     std::uniform_int_distribution<int> dist(0, players.size() - 1);
     Entity random_player = players[dist(engine)];
 
-    auto optionalPlayerPosition = manager.getRegistry().get_components<PositionComponent>()[random_player];
-    if (!optionalPlayerPosition.has_value())
+    PositionComponent *optionalPlayerPosition =
+        manager.getRegistry().get_components<PositionComponent>().find(random_player);
+    if (optionalPlayerPosition == nullptr)
         return;
 
-    PositionComponent playerPosition = optionalPlayerPosition.value();
+    PositionComponent playerPosition = *optionalPlayerPosition;
 
     PositionComponent orbSpawnPoint0 = {1550.0f, 240.0f};
     PositionComponent orbSpawnPoint1 = {1550.0f, 840.0f};
 
-    VelocityComponent orbVelocity0 = calculateOrbVelocity(playerPosition, orbSpawnPoint0, 500.0f, 60);
-    VelocityComponent orbVelocity1 = calculateOrbVelocity(playerPosition, orbSpawnPoint1, 500.0f, 60);
+    VelocityComponent orbVelocity0 = calculateOrbVelocity(playerPosition, orbSpawnPoint0, 500.0f);
+    VelocityComponent orbVelocity1 = calculateOrbVelocity(playerPosition, orbSpawnPoint1, 500.0f);
 
     auto now = std::chrono::high_resolution_clock::now();
     auto timeSinceLastOrb = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastOrbTime).count();
@@ -61,7 +61,10 @@ void thirdLvlMobsAI(Manager &manager, const std::chrono::time_point<std::chrono:
     }
 }
 
-ThirdLevelScene::ThirdLevelScene(Manager &manager) : AScene(manager), _mobs(std::vector<Entity>()) {}
+ThirdLevelScene::ThirdLevelScene(Manager &manager)
+    : AScene(manager), _mobs(std::vector<Entity>()), _firstMobAlive(true), _secondMobAlive(true),
+      _lastOrbTime(std::chrono::high_resolution_clock::now())
+{}
 
 ThirdLevelScene::~ThirdLevelScene() {}
 
@@ -70,6 +73,10 @@ void ThirdLevelScene::enter()
     restartPlayerPositions(*_manager);
 
     // Add entities
+    _mobs.clear();
+    _firstMobAlive = true;
+    _secondMobAlive = true;
+    _lastOrbTime = std::chrono::high_resolution_clock::now();
     _mobs.push_back(createMob(_manager->getRegistry(), {1500.0f, 250.0f}, {0.0f, 0.0f}, {200}));
     _mobs.push_back(createMob(_manager->getRegistry(), {1500.0f, 850.0f}, {0.0f, 0.0f}, {200}));
 }
@@ -81,27 +88,22 @@ void ThirdLevelScene::exit()
 }
 
 void ThirdLevelScene::update(const std::chrono::time_point<std::chrono::high_resolution_clock> &sceneStartTime,
-                             SceneEvent &event)
+                             SceneEvent &event, float dt)
 {
     // Update the ThirdLevelScene scene
-    static bool firstMobAlive = true;
-    static bool secondMobAlive = true;
+    Registry &registry = _manager->getRegistry();
 
-    static Entity firstMob = _mobs[0];
-    static Entity secondMob = _mobs[1];
+    processUserInput(*_manager, sceneStartTime, dt);
 
-    processUserInput(*_manager, sceneStartTime);
+    registry.run_systems(dt);
 
-    _manager->getRegistry().run_systems();
-    auto &healthArray = _manager->getRegistry().get_components<HealthComponent>();
+    // Check which mob dies to remove orbs, health_system already killed it and its id may be reused
+    if (!registry.is_alive(_mobs[0]))
+        _firstMobAlive = false;
+    if (!registry.is_alive(_mobs[1]))
+        _secondMobAlive = false;
 
-    // Check which mob dies to remove orbs
-    if (healthArray[firstMob].has_value() && healthArray[firstMob]->value <= 0)
-        firstMobAlive = false;
-    if (healthArray[secondMob].has_value() && healthArray[secondMob]->value <= 0)
-        secondMobAlive = false;
-
-    thirdLvlMobsAI(*_manager, sceneStartTime, firstMobAlive, secondMobAlive);
+    thirdLvlMobsAI(*_manager, sceneStartTime, _firstMobAlive, _secondMobAlive, _lastOrbTime);
 
     // If no more enemies, next scene
     if (!mobsAlive(_manager->getRegistry()))
@@ -109,6 +111,6 @@ void ThirdLevelScene::update(const std::chrono::time_point<std::chrono::high_res
         event.event = Event::NEXT;
     }
 
-    StateUpdateMessage state = processOutput(*_manager);
-    _manager->pushStateUpdate(state);
+    // Build the state update straight into the manager ring
+    _manager->pushStateUpdate([this](StateUpdateMessage &state) { processOutput(*_manager, state); });
 }
@@ -0,0 +1,194 @@
+#include "SimdKernels.hpp"
+
+#include "AScene.hpp"
+
+#include <cstdint>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+using namespace server;
+
+// The kernels read {x, y} and {vx, vy} pairs straight out of the arrays
+static_assert(sizeof(PositionComponent) == 2 * sizeof(float), "PositionComponent must be two packed floats");
+static_assert(sizeof(VelocityComponent) == 2 * sizeof(float), "VelocityComponent must be two packed floats");
+
+namespace
+{
+
+// Scalar versions, used for the entities left over by the vector loops (all of them without SSE2)
+void integrate_one(PositionComponent &pos, const VelocityComponent &vel, float dt)
+{
+    pos.x += vel.vx * dt;
+    pos.y += vel.vy * dt;
+}
+
+void wrap_one(PositionComponent &pos, EntityType type)
+{
+    if (type == EntityType::BULLET)
+        return;
+
+    pos.y = (pos.y < WORLD_MIN_HEIGHT)   ? WORLD_MAX_HEIGHT
+            : (pos.y > WORLD_MAX_HEIGHT) ? WORLD_MIN_HEIGHT
+                                         : pos.y;
+
+    if (type == EntityType::PLAYER)
+        return;
+    pos.x = (pos.x < WORLD_MIN_WIDTH - 170) ? WORLD_MAX_WIDTH
+            : (pos.x > WORLD_MAX_WIDTH)     ? WORLD_MIN_WIDTH - 170
+                                            : pos.x;
+}
+
+void bound_one(PositionComponent &pos, HealthComponent &health, EntityType type)
+{
+    // Kills bullets that go out of bounds
+    if (type == EntityType::BULLET || type == EntityType::ORB)
+    {
+        if (pos.x < WORLD_MIN_WIDTH || pos.x > WORLD_MAX_WIDTH || pos.y < WORLD_MIN_HEIGHT || pos.y > WORLD_MAX_HEIGHT)
+            health.value = 0;
+    }
+    // Makes sure players don't HORZONTALLY wrap around the screen
+    if (type == EntityType::PLAYER)
+    {
+        pos.x = (pos.x < WORLD_MIN_WIDTH)         ? WORLD_MIN_WIDTH
+                : (pos.x > WORLD_MAX_WIDTH - 175) ? WORLD_MAX_WIDTH - 175
+                                                  : pos.x;
+    }
+}
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+    #define SIMD_KERNELS
+
+// Thin layer over the instruction set, a vector holds the {x, y} pairs of LANE_ENTITIES entities.
+// Masks are vectors whose lanes are all ones (true) or all zeros (false).
+    #if defined(__AVX2__)
+constexpr size_t LANE_ENTITIES = 4;
+using Vector = __m256;
+
+Vector load(const float *src) { return _mm256_loadu_ps(src); }
+void store(float *dst, Vector v) { _mm256_storeu_ps(dst, v); }
+Vector splat(float value) { return _mm256_set1_ps(value); }
+Vector pairs(float x, float y) { return _mm256_setr_ps(x, y, x, y, x, y, x, y); }
+Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+Vector mul(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+Vector less(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+Vector greater(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+Vector either(Vector a, Vector b) { return _mm256_or_ps(a, b); }
+Vector select(Vector mask, Vector a, Vector b) { return _mm256_blendv_ps(b, a, mask); }  // mask ? a : b
+int bits(Vector mask) { return _mm256_movemask_ps(mask); }  // One bit per lane
+Vector mask(const int32_t *lanes) { return _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i *)lanes)); }
+    #else
+constexpr size_t LANE_ENTITIES = 2;
+using Vector = __m128;
+
+Vector load(const float *src) { return _mm_loadu_ps(src); }
+void store(float *dst, Vector v) { _mm_storeu_ps(dst, v); }
+Vector splat(float value) { return _mm_set1_ps(value); }
+Vector pairs(float x, float y) { return _mm_setr_ps(x, y, x, y); }
+Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+Vector less(Vector a, Vector b) { return _mm_cmplt_ps(a, b); }
+Vector greater(Vector a, Vector b) { return _mm_cmpgt_ps(a, b); }
+Vector either(Vector a, Vector b) { return _mm_or_ps(a, b); }
+Vector select(Vector mask, Vector a, Vector b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+int bits(Vector mask) { return _mm_movemask_ps(mask); }
+Vector mask(const int32_t *lanes) { return _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)lanes)); }
+    #endif
+
+constexpr size_t LANES = LANE_ENTITIES * 2;
+
+// v < lo ? hi : v > hi ? lo : v
+Vector wrap(Vector v, Vector lo, Vector hi)
+{
+    return select(less(v, lo), hi, select(greater(v, hi), lo, v));
+}
+
+// v < lo ? lo : v > hi ? hi : v, same comparisons as the scalar code (min/max differ on NaN)
+Vector clamp(Vector v, Vector lo, Vector hi)
+{
+    return select(less(v, lo), lo, select(greater(v, hi), hi, v));
+}
+#endif
+
+}  // namespace
+
+void server::integrate_positions(PositionComponent *positions, const VelocityComponent *velocities, size_t count,
+                                 float dt)
+{
+    size_t i = 0;
+
+#ifdef SIMD_KERNELS
+    // mul then add, not fused, so the results match the scalar code
+    const Vector delta = splat(dt);
+
+    for (; i + LANE_ENTITIES <= count; i += LANE_ENTITIES)
+    {
+        Vector pos = load(&positions[i].x);
+        store(&positions[i].x, add(pos, mul(load(&velocities[i].vx), delta)));
+    }
+#endif
+    for (; i < count; i++)
+        integrate_one(positions[i], velocities[i], dt);
+}
+
+void server::wrap_positions(PositionComponent *positions, const EntityTypeComponent *types, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SIMD_KERNELS
+    const Vector lo = pairs(WORLD_MIN_WIDTH - 170, WORLD_MIN_HEIGHT);
+    const Vector hi = pairs(WORLD_MAX_WIDTH, WORLD_MAX_HEIGHT);
+    int32_t wrapped[LANES];
+
+    for (; i + LANE_ENTITIES <= count; i += LANE_ENTITIES)
+    {
+        for (size_t e = 0; e < LANE_ENTITIES; e++)
+        {
+            EntityType type = types[i + e].type;
+            wrapped[e * 2] = -int32_t(type != EntityType::BULLET && type != EntityType::PLAYER);
+            wrapped[e * 2 + 1] = -int32_t(type != EntityType::BULLET);
+        }
+        Vector pos = load(&positions[i].x);
+        store(&positions[i].x, select(mask(wrapped), wrap(pos, lo, hi), pos));
+    }
+#endif
+    for (; i < count; i++)
+        wrap_one(positions[i], types[i].type);
+}
+
+void server::bound_positions(PositionComponent *positions, HealthComponent *healths, const EntityTypeComponent *types,
+                             size_t count)
+{
+    size_t i = 0;
+
+#ifdef SIMD_KERNELS
+    const Vector worldMin = pairs(WORLD_MIN_WIDTH, WORLD_MIN_HEIGHT);
+    const Vector worldMax = pairs(WORLD_MAX_WIDTH, WORLD_MAX_HEIGHT);
+    const Vector playerMin = pairs(WORLD_MIN_WIDTH, WORLD_MIN_HEIGHT);
+    const Vector playerMax = pairs(WORLD_MAX_WIDTH - 175, WORLD_MAX_HEIGHT);
+    int32_t clamped[LANES];
+
+    for (; i + LANE_ENTITIES <= count; i += LANE_ENTITIES)
+    {
+        Vector pos = load(&positions[i].x);
+        int outside = bits(either(less(pos, worldMin), greater(pos, worldMax)));
+
+        for (size_t e = 0; e < LANE_ENTITIES; e++)
+        {
+            EntityType type = types[i + e].type;
+            bool killed = (type == EntityType::BULLET || type == EntityType::ORB) && ((outside >> (e * 2)) & 3);
+
+            healths[i + e].value = killed ? 0 : healths[i + e].value;
+            // Only the x lane of players is clamped
+            clamped[e * 2] = -int32_t(type == EntityType::PLAYER);
+            clamped[e * 2 + 1] = 0;
+        }
+        store(&positions[i].x, select(mask(clamped), clamp(pos, playerMin, playerMax), pos));
+    }
+#endif
+    for (; i < count; i++)
+        bound_one(positions[i], healths[i], types[i].type);
+}
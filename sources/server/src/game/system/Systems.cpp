@@ -2,171 +2,154 @@
 
 #include "AScene.hpp"
 #include "EntityTypeComponent.hpp"
+#include "IndexedZipper.hpp"
+#include "SimdKernels.hpp"
+#include "SpatialHash.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <vector>
 
 using namespace server;
 
-void server::out_of_bounds_system(Registry &r, SparseArray<PositionComponent> &positions,
-                                  SparseArray<HealthComponent> &healths, SparseArray<EntityTypeComponent> &types)
+namespace
 {
-    for (size_t i = 0; i < positions.size() && i < types.size() && i < healths.size(); ++i)
+
+// Side of a broad phase cell, close to the widest hitbox (300px) so a query touches at most 3x2 cells
+constexpr float COLLISION_CELL_SIZE = 256.0f;
+
+// Collision layers, an entity is only tested against the layers its type can actually hit
+enum CollisionLayer : uint32_t
+{
+    LAYER_NONE = 0,
+    LAYER_MOB = 1 << 0,
+    LAYER_BOSS = 1 << 1,
+    LAYER_ORB = 1 << 2,
+};
+
+// Layer an entity is stored in, players and bullets are only ever the ones querying the grid
+uint32_t collision_layer(EntityType type)
+{
+    switch (type)
     {
-        if (positions[i].has_value() && types[i].has_value() && healths[i].has_value())
-        {
-            // Kills bullets that go out of bounds
-            if (types[i].value().type == EntityType::BULLET || types[i].value().type == EntityType::ORB)
-            {
-                if (positions[i].value().x < WORLD_MIN_WIDTH || positions[i].value().x > WORLD_MAX_WIDTH ||
-                    positions[i].value().y < WORLD_MIN_HEIGHT || positions[i].value().y > WORLD_MAX_HEIGHT)
-                {
-                    healths[i].value().value = 0;
-                }
-            }
-            // Makes sure players don't HORZONTALLY wrap around the screen
-            if (types[i].value().type == EntityType::PLAYER)
-            {
-                positions[i].value().x = (positions[i].value().x < WORLD_MIN_WIDTH)         ? WORLD_MIN_WIDTH
-                                         : (positions[i].value().x > WORLD_MAX_WIDTH - 175) ? WORLD_MAX_WIDTH - 175
-                                                                                            : positions[i].value().x;
-            }
-        }
+        case EntityType::MOB: return LAYER_MOB;
+        case EntityType::BOSS: return LAYER_BOSS;
+        case EntityType::ORB: return LAYER_ORB;
+        default: return LAYER_NONE;
     }
 }
 
-void server::position_wrapping_system(Registry &r, SparseArray<PositionComponent> &positions,
-                                      SparseArray<EntityTypeComponent> &types)
+}  // namespace
+
+void server::out_of_bounds_system(Registry &r, ComponentArray<PositionComponent> &positions,
+                                  ComponentArray<HealthComponent> &healths, ComponentArray<EntityTypeComponent> &types)
 {
-    for (size_t i = 0; i < positions.size() && i < types.size(); ++i)
-    {
-        if (positions[i].has_value() && types[i].has_value())
-        {
-            if (types[i].value().type == EntityType::BULLET)
-                continue;
-            // condition ? value_if_true : condition ? value_if_true : value_if_false (AKA default value);
-            positions[i].value().y = (positions[i].value().y < WORLD_MIN_HEIGHT)   ? WORLD_MAX_HEIGHT
-                                     : (positions[i].value().y > WORLD_MAX_HEIGHT) ? WORLD_MIN_HEIGHT
-                                                                                   : positions[i].value().y;
-
-            if (types[i].value().type == EntityType::PLAYER)
-                continue;
-            positions[i].value().x = (positions[i].value().x < WORLD_MIN_WIDTH - 170) ? WORLD_MAX_WIDTH
-                                     : (positions[i].value().x > WORLD_MAX_WIDTH)     ? WORLD_MIN_WIDTH - 170
-                                                                                      : positions[i].value().x;
-        }
-    }
+    size_t count = r.group<PositionComponent, HealthComponent, EntityTypeComponent>();
+
+    r.parallel_chunks<PositionComponent, HealthComponent, EntityTypeComponent>(count, [&](size_t first, size_t n) {
+        bound_positions(positions.data() + first, healths.data() + first, types.data() + first, n);
+    });
 }
 
-void server::position_system(Registry &r, SparseArray<PositionComponent> &positions,
-                             SparseArray<VelocityComponent> &velocities)
+void server::position_wrapping_system(Registry &r, ComponentArray<PositionComponent> &positions,
+                                      ComponentArray<EntityTypeComponent> &types)
 {
-    for (size_t i = 0; i < positions.size() && i < velocities.size(); ++i)
-    {
-        if (positions[i].has_value() && velocities[i].has_value())
-        {
-            positions[i].value().x += velocities[i].value().vx;
-            positions[i].value().y += velocities[i].value().vy;
-        }
-    }
+    size_t count = r.group<PositionComponent, EntityTypeComponent>();
+
+    r.parallel_chunks<PositionComponent, EntityTypeComponent>(count, [&](size_t first, size_t n) {
+        wrap_positions(positions.data() + first, types.data() + first, n);
+    });
+}
+
+void server::position_system(Registry &r, ComponentArray<PositionComponent> &positions,
+                             ComponentArray<VelocityComponent> &velocities)
+{
+    // Velocities are in units per second
+    float dt = r.delta_time();
+    size_t count = r.group<PositionComponent, VelocityComponent>();
+
+    r.parallel_chunks<PositionComponent, VelocityComponent>(count, [&](size_t first, size_t n) {
+        integrate_positions(positions.data() + first, velocities.data() + first, n, dt);
+    });
 }
 
-void server::health_system(Registry &r, SparseArray<HealthComponent> &healths)
+void server::health_system(Registry &r, ComponentArray<HealthComponent> &healths)
 {
-    for (size_t i = 0; i < healths.size(); ++i)
+    // Killing moves components around the packed arrays, so it is deferred until the systems are done
+    CommandBuffer &commands = r.commands();
+
+    for (auto &&[id, health] : IndexedZipper(healths))
     {
-        if (healths[i].has_value())
-        {
-            // Kill entity if health <= 0
-            if (healths[i].value().value <= 0)
-            {
-                const Entity &entity = static_cast<Entity>(i);
-                r.kill_entity(entity);
-                continue;
-            }
-        }
+        // Kill entity if health <= 0
+        if (health.value <= 0)
+            commands.kill_entity(r.entity_at(id));
     }
 }
 
-void server::collision_system(Registry &r, SparseArray<PositionComponent> &positions,
-                              SparseArray<VelocityComponent> &velocities, SparseArray<HealthComponent> &healths,
-                              SparseArray<EntityTypeComponent> &types)
+void server::collision_system(Registry &r, ComponentArray<PositionComponent> &positions,
+                              ComponentArray<VelocityComponent> &velocities, ComponentArray<HealthComponent> &healths,
+                              ComponentArray<EntityTypeComponent> &types)
 {
-    for (size_t curr = 0;
-         curr < positions.size() && curr < velocities.size() && curr < healths.size() && curr < types.size(); ++curr)
+    // Broad phase grid, one per thread so its buffers are reused from a tick to the next
+    thread_local SpatialHash grid(WORLD_MIN_WIDTH, WORLD_MIN_HEIGHT, WORLD_MAX_WIDTH, WORLD_MAX_HEIGHT,
+                                  COLLISION_CELL_SIZE);
+
+    // Only entities owning the four components take part in collisions
+    auto collidables = IndexedZipper(types, positions, velocities, healths);
+
+    // Only the entities something can collide with are put in the grid.
+    // Entities health_system killed are only removed at the end of the tick, they don't collide anymore
+    grid.clear();
+    for (auto &&[id, type, pos, vel, health] : collidables)
+    {
+        uint32_t layer = collision_layer(type.type);
+        if (layer && health.value > 0)
+            grid.insert(id, pos.x, pos.y, layer);
+    }
+    grid.build();
+
+    for (auto &&[currId, currType, currPos, currVel, currHealth] : collidables)
     {
-        if (positions[curr].has_value() && velocities[curr].has_value() && healths[curr].has_value() &&
-            types[curr].has_value())
+        if (currHealth.value <= 0)
+            continue;
+
+        switch (currType.type)
         {
-            switch (types[curr].value().type)
-            {
-                case EntityType::ORB: break;
-                case EntityType::MOB: break;
-                case EntityType::BOSS: break;
-                case EntityType::PLAYER:
-
-                    for (size_t other = 0; other < positions.size() && other < velocities.size() &&
-                                           other < healths.size() && other < types.size();
-                         ++other)
-                    {
-                        if (positions[other].has_value() && velocities[other].has_value() &&
-                            healths[other].has_value() && types[other].has_value())
-                        {
-                            // Skip same entity
-                            if (curr == other)
-                                continue;
-
-                            // Check for player - mob collision
-                            if (types[other].value().type == EntityType::MOB)
-                            {
-                                if (positions[curr].value().x > positions[other].value().x - 100.0f &&
-                                    positions[curr].value().x < positions[other].value().x + 200.0f &&
-                                    positions[curr].value().y > positions[other].value().y - 40.0f &&
-                                    positions[curr].value().y < positions[other].value().y + 10.0f)
-                                {
-                                    healths[curr].value().value -= 50;
-                                }
-                            }
-                            if (types[other].value().type == EntityType::ORB)
-                            {
-                                if (positions[curr].value().x + 100.0f > positions[other].value().x &&
-                                    positions[curr].value().x < positions[other].value().x &&
-                                    positions[curr].value().y + 50.0f > positions[other].value().y &&
-                                    positions[curr].value().y < positions[other].value().y)
-                                {
-                                    healths[curr].value().value -= 20;
-                                    healths[other].value().value = 0;
-                                }
-                            }
-                        }
-                    }
-                case EntityType::BULLET:
-                    for (size_t other = 0; other < positions.size() && other < velocities.size() &&
-                                           other < healths.size() && other < types.size();
-                         ++other)
-                    {
-                        if (positions[other].has_value() && velocities[other].has_value() &&
-                            healths[other].has_value() && types[other].has_value())
-                        {
-                            if (curr == other)
-                                continue;
-
-                            // Check for bullet - mob/boss collision
-                            if (types[other].value().type == EntityType::MOB ||
-                                types[other].value().type == EntityType::BOSS)
-                            {
-                                if (positions[curr].value().x > positions[other].value().x - 30.0f &&
-                                    positions[curr].value().x < positions[other].value().x + 30.0f &&
-                                    positions[curr].value().y > positions[other].value().y - 40.0f &&
-                                    positions[curr].value().y < positions[other].value().y + 10.0f)
-                                {
-                                    healths[other].value().value -= 50;
-                                    healths[curr].value().value = 0;
-                                }
-                            }
-                        }
-                    }
-            }
+            case EntityType::PLAYER:
+                // Check for player - mob collision
+                grid.query(currPos.x - 200.0f, currPos.y - 10.0f, currPos.x + 100.0f, currPos.y + 40.0f, LAYER_MOB,
+                           [&](const SpatialHash::Entry &other) {
+                               if (currPos.x > other.x - 100.0f && currPos.x < other.x + 200.0f &&
+                                   currPos.y > other.y - 40.0f && currPos.y < other.y + 10.0f)
+                               {
+                                   currHealth.value -= 50;
+                               }
+                           });
+                // Check for player - orb collision
+                grid.query(currPos.x, currPos.y, currPos.x + 100.0f, currPos.y + 50.0f, LAYER_ORB,
+                           [&](const SpatialHash::Entry &other) {
+                               if (currPos.x + 100.0f > other.x && currPos.x < other.x &&
+                                   currPos.y + 50.0f > other.y && currPos.y < other.y)
+                               {
+                                   currHealth.value -= 20;
+                                   healths[other.id].value = 0;
+                               }
+                           });
+                break;
+            case EntityType::BULLET:
+                // Check for bullet - mob/boss collision
+                grid.query(currPos.x - 30.0f, currPos.y - 10.0f, currPos.x + 30.0f, currPos.y + 40.0f,
+                           LAYER_MOB | LAYER_BOSS, [&](const SpatialHash::Entry &other) {
+                               if (currPos.x > other.x - 30.0f && currPos.x < other.x + 30.0f &&
+                                   currPos.y > other.y - 40.0f && currPos.y < other.y + 10.0f)
+                               {
+                                   healths[other.id].value -= 50;
+                                   currHealth.value = 0;
+                               }
+                           });
+                break;
+            default: break;
         }
     }
-}
\ No newline at end of file
+}
@@ -7,13 +7,16 @@ using namespace server;
 
 int main(int argc, char *argv[])
 {
-    if (argc != 2)
+    if (argc < 2 || argc > 4)
     {
-        std::cerr << "Usage: " << argv[0] << " [PORT]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [PORT] [TICK_RATE (default " << DEFAULT_TICK_RATE
+                  << ")] [WORKER_THREADS (default: hardware threads - 1)]" << std::endl;
         return 1;
     }
 
     unsigned short port = static_cast<unsigned short>(std::stoi(argv[1]));
-    Server server(port);
+    unsigned int tickRate = (argc >= 3) ? static_cast<unsigned int>(std::stoul(argv[2])) : DEFAULT_TICK_RATE;
+    unsigned int workerThreads = (argc == 4) ? static_cast<unsigned int>(std::stoul(argv[3])) : 0;
+    Server server(port, tickRate, workerThreads);
     server.run();
 }
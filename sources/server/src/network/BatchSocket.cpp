@@ -0,0 +1,110 @@
+#include "BatchSocket.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+using namespace server;
+
+BatchSocket::BatchSocket(asio::ip::udp::socket &socket) : _socket(socket), _sizes() {}
+
+BatchSocket::~BatchSocket() {}
+
+std::span<const uint8_t> BatchSocket::datagram(size_t index) const
+{
+    return std::span<const uint8_t>(_recvBuffers[index].data(), _sizes[index]);
+}
+
+const asio::ip::udp::endpoint &BatchSocket::sender(size_t index) const
+{
+    return _senders[index];
+}
+
+#ifdef SERVER_BATCH_IO
+
+static asio::error_code lastError()
+{
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return asio::error::would_block;
+    return asio::error_code(errno, asio::error::get_system_category());
+}
+
+size_t BatchSocket::receive(asio::error_code &error)
+{
+    error.clear();
+    for (size_t i = 0; i < RECV_BATCH_SIZE; ++i)
+    {
+        _recvVectors[i] = {_recvBuffers[i].data(), _recvBuffers[i].size()};
+        _recvHeaders[i] = {};
+        _recvHeaders[i].msg_hdr.msg_name = _senders[i].data();
+        _recvHeaders[i].msg_hdr.msg_namelen = static_cast<socklen_t>(_senders[i].capacity());
+        _recvHeaders[i].msg_hdr.msg_iov = &_recvVectors[i];
+        _recvHeaders[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int received = recvmmsg(_socket.native_handle(), _recvHeaders.data(), RECV_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+    if (received < 0)
+    {
+        error = lastError();
+        return 0;
+    }
+
+    for (int i = 0; i < received; ++i)
+    {
+        _sizes[i] = _recvHeaders[i].msg_len;
+        _senders[i].resize(_recvHeaders[i].msg_hdr.msg_namelen);
+    }
+    return static_cast<size_t>(received);
+}
+
+size_t BatchSocket::send(std::span<const OutgoingDatagram> datagrams, asio::error_code &error)
+{
+    size_t sent = 0;
+
+    error.clear();
+    while (sent < datagrams.size())
+    {
+        size_t count = std::min<size_t>(datagrams.size() - sent, SEND_BATCH_SIZE);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const OutgoingDatagram &datagram = datagrams[sent + i];
+
+            _sendVectors[i] = {datagram.buffer->bytes.data(), datagram.buffer->size};
+            _sendHeaders[i] = {};
+            _sendHeaders[i].msg_hdr.msg_name = const_cast<asio::detail::socket_addr_type *>(datagram.endpoint.data());
+            _sendHeaders[i].msg_hdr.msg_namelen = static_cast<socklen_t>(datagram.endpoint.size());
+            _sendHeaders[i].msg_hdr.msg_iov = &_sendVectors[i];
+            _sendHeaders[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // The kernel copies the datagrams, the buffers are free again once this returns
+        int batch = sendmmsg(_socket.native_handle(), _sendHeaders.data(), static_cast<unsigned int>(count),
+                             MSG_DONTWAIT);
+        if (batch < 0)
+        {
+            error = lastError();
+            return sent;
+        }
+        sent += static_cast<size_t>(batch);
+        // Stopped early (the next one would block or failed), the caller sends the rest another way
+        if (static_cast<size_t>(batch) < count)
+            break;
+    }
+    return sent;
+}
+
+#else
+
+size_t BatchSocket::receive(asio::error_code &error)
+{
+    error = asio::error::operation_not_supported;
+    return 0;
+}
+
+size_t BatchSocket::send(std::span<const OutgoingDatagram> /*datagrams*/, asio::error_code &error)
+{
+    error = asio::error::operation_not_supported;
+    return 0;
+}
+
+#endif
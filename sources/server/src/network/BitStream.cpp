@@ -0,0 +1,95 @@
+#include "BitStream.hpp"
+
+#include <stdexcept>
+
+using namespace server;
+
+// Mask of the low bits of a value (bits <= 32)
+static uint64_t lowBits(unsigned int bits)
+{
+    return (uint64_t(1) << bits) - 1;
+}
+
+BitWriter::BitWriter(SpanWriter &writer) : _writer(writer), _scratch(0), _count(0) {}
+
+BitWriter::~BitWriter() {}
+
+void BitWriter::write(uint32_t value, unsigned int bits)
+{
+    _scratch |= (value & lowBits(bits)) << _count;
+    _count += bits;
+    while (_count >= 8)
+    {
+        _writer.writeByte(static_cast<uint8_t>(_scratch));
+        _scratch >>= 8;
+        _count -= 8;
+    }
+}
+
+void BitWriter::writeVarint(uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        write((value & 0x7F) | 0x80, 8);
+        value >>= 7;
+    }
+    write(value, 8);
+}
+
+void BitWriter::flush()
+{
+    if (_count > 0)
+        _writer.writeByte(static_cast<uint8_t>(_scratch));
+    _scratch = 0;
+    _count = 0;
+}
+
+BitReader::BitReader(std::span<const uint8_t> buffer, size_t offset)
+    : _buffer(buffer), _offset(offset), _scratch(0), _count(0)
+{}
+
+BitReader::~BitReader() {}
+
+uint32_t BitReader::read(unsigned int bits)
+{
+    while (_count < bits)
+    {
+        if (_offset >= _buffer.size())
+            throw std::runtime_error("Bit stream read past the end of the buffer");
+        _scratch |= uint64_t(_buffer[_offset++]) << _count;
+        _count += 8;
+    }
+
+    uint32_t value = static_cast<uint32_t>(_scratch & lowBits(bits));
+    _scratch >>= bits;
+    _count -= bits;
+    return value;
+}
+
+uint32_t BitReader::readVarint()
+{
+    uint32_t value = 0;
+
+    // A uint32_t never takes more than 5 groups
+    for (unsigned int shift = 0; shift < 35; shift += 7)
+    {
+        uint32_t group = read(8);
+
+        value |= (group & 0x7F) << shift;
+        if ((group & 0x80) == 0)
+            return value;
+    }
+    throw std::runtime_error("Malformed varint in bit stream");
+}
+
+unsigned int server::varintBits(uint32_t value)
+{
+    unsigned int bits = 8;
+
+    while (value >= 0x80)
+    {
+        bits += 8;
+        value >>= 7;
+    }
+    return bits;
+}
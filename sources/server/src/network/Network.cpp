@@ -2,92 +2,170 @@
 
 #include "Protocol.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 using namespace server;
 
-NetworkServer::NetworkServer(asio::io_context &io_context, unsigned short port, Manager &manager)
-    : socket_(io_context, asio::ip::udp::endpoint(asio::ip::udp::v4(), port)), _manager(manager)
-{}
+NetworkServer::NetworkServer(asio::io_context &io_context, unsigned short port, RoomManager &rooms)
+    : _io_context(io_context), _strand(asio::make_strand(io_context)),
+      socket_(io_context, asio::ip::udp::endpoint(asio::ip::udp::v4(), port)), _batch(socket_), _rooms(rooms),
+      _controlTimer(io_context)
+{
+    _outgoing.reserve(SEND_BATCH_SIZE);
+}
 
 NetworkServer::~NetworkServer()
 {
-    _running = false;  // Stop the processing thread
-    if (_managerProcessingThread.joinable())
+    std::vector<std::shared_ptr<Room>> rooms;
+
+    _rooms.setRoomOpenedCallback(nullptr);
+    _rooms.setRoomClosedCallback(nullptr);
+    _rooms.rooms(rooms);
+    for (const auto &room : rooms)
     {
-        _managerProcessingThread.join();
+        room->getManager().setOutputCallback(nullptr);
     }
 }
 
 void NetworkServer::start()
 {
     std::cout << "Server started, waiting for connections..." << std::endl;
+
+    // Rooms are opened by handleConnect (on the strand), closed by the game loop
+    _rooms.setRoomOpenedCallback([this](const std::shared_ptr<Room> &room) { openChannel(room); });
+    _rooms.setRoomClosedCallback([this](const std::shared_ptr<Room> &room) {
+        asio::post(_strand, [this, roomId = room->id()]() { _channels.erase(roomId); });
+    });
     startReceive();
+    startControlTimer();
+}
 
-    // Start a thread to process the Manager's queue
-    _managerProcessingThread = std::thread([this]() {
-        while (_running)
-        {
-            processGameOver();
-            processManagerQueue();
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Check every 100ms
-        }
+void NetworkServer::openChannel(const std::shared_ptr<Room> &room)
+{
+    auto &channel = _channels[room->id()];
+    auto pending = std::make_shared<std::atomic<bool>>(false);
+
+    channel = std::make_unique<RoomChannel>();
+    channel->room = room;
+    // The game loop wakes us up as soon as a tick of the room produced something, no polling
+    room->getManager().setOutputCallback([this, roomId = room->id(), pending]() { notifyOutput(roomId, pending); });
+}
+
+void NetworkServer::notifyOutput(uint32_t roomId, const std::shared_ptr<std::atomic<bool>> &pending)
+{
+    // Several ticks may be pushed before the strand gets to run, a single pass drains them all
+    if (pending->exchange(true))
+        return;
+
+    asio::post(_strand, [this, roomId, pending]() {
+        *pending = false;
+        auto channel = _channels.find(roomId);
+        if (channel == _channels.end())
+            return;
+        processManagerQueue(*channel->second);
+        processGameOver(roomId);
     });
 }
 
-void NetworkServer::processGameOver()
+NetworkServer::RoomChannel *NetworkServer::findChannel(uint32_t clientId)
+{
+    std::shared_ptr<Room> room = _rooms.find(clientId);
+    if (!room)
+        return nullptr;
+
+    auto channel = _channels.find(room->id());
+    return (channel != _channels.end()) ? channel->second.get() : nullptr;
+}
+
+void NetworkServer::processGameOver(uint32_t roomId)
 {
-    auto [isOver, condition] = _manager.getGameOverStatus();
-    auto clients = _manager.getClients();
+    auto found = _channels.find(roomId);
+    if (found == _channels.end())
+        return;
+
+    RoomChannel &channel = *found->second;
+    std::shared_ptr<Room> room = channel.room.lock();
+    if (!room)
+        return;
 
-    for (const auto &[clientId, endpoint] : clients_)
+    auto [isOver, condition] = room->getManager().getGameOverStatus();
+    if (!isOver || channel.gameOverSent)
+        return;
+
+    // Sent once, the reliable channels resend it until each client got it
+    for (const auto &[clientId, client] : channel.clients)
     {
-        std::vector<uint8_t> buffer;
         GameOverMessage go = {
             {static_cast<uint16_t>(MessageType::GameOver), sizeof(GameOverMessage)},
             clientId,
             condition
         };
-        serializeGameOverMessage(go, buffer);
-        sendMessage(buffer, endpoint);
+        sendControl(clientId, client.endpoint, go, serializeGameOverMessage);
     }
+    channel.gameOverSent = true;
 }
 
-void NetworkServer::processManagerQueue()
+void NetworkServer::processManagerQueue(RoomChannel &channel)
 {
-    StateUpdateMessage stateMsg;
+    std::shared_ptr<Room> room = channel.room.lock();
+    // Swapped with the ring slots, so the entity buffers go back to the game loop
+    StateUpdateMessage &stateMsg = channel.stateMsg;
+
+    if (!room)
+        return;
 
     // Process state updates from the manager
-    while (_manager.popStateUpdate(stateMsg))
+    while (room->getManager().popStateUpdate(stateMsg))
     {
-        std::cout << "Server processing state update for " << stateMsg.numEntities << " entities from ECS."
-                  << std::endl;
-
-        // For now, print the state updates (Later: send to clients)
-        for (const auto &entity : stateMsg.entities)
-        {
-            std::cout << "Entity ID: " << entity.entityId << " PosX: " << entity.posX << " PosY: " << entity.posY
-                      << " Health: " << int(entity.health) << std::endl;
-        }
-        sendGameState(stateMsg);
+        sendGameState(channel, stateMsg);
     }
 }
 
 // Handle received messages
 void NetworkServer::startReceive()
 {
-    socket_.async_receive_from(asio::buffer(recv_buffer_), sender_endpoint_,
-                               [this](const asio::error_code &error, std::size_t bytes_transferred) {
+#ifdef SERVER_BATCH_IO
+    // Only wait for the socket to be readable, handleReadable reads the datagrams by batches
+    socket_.async_wait(asio::socket_base::wait_read,
+                       asio::bind_executor(_strand, [this](const asio::error_code &error) { handleReadable(error); }));
+#else
+    socket_.async_receive_from(
+        asio::buffer(recv_buffer_), sender_endpoint_,
+        asio::bind_executor(_strand, [this](const asio::error_code &error, std::size_t bytes_transferred) {
         handleReceive(error, bytes_transferred);
-    });
+    }));
+#endif
+}
+
+void NetworkServer::handleReadable(const asio::error_code &error)
+{
+    asio::error_code receiveError = error;
+    size_t received = 0;
+
+    if (!receiveError)
+        received = _batch.receive(receiveError);
+    // Decoded in place, the batch isn't received over before the last handleMessage returns
+    for (size_t i = 0; i < received; ++i)
+        handleDatagram(_batch.datagram(i), _batch.sender(i));
+    if (receiveError && receiveError != asio::error::would_block)
+        std::cerr << "Error receiving message: " << receiveError.message() << std::endl;
+
+    // A full batch may have left datagrams in the socket, read them once the strand ran what else is waiting on it.
+    // Otherwise the socket was drained, the next datagram wakes us up.
+    if (received == RECV_BATCH_SIZE)
+        asio::post(_strand, [this]() { handleReadable(asio::error_code()); });
+    else
+        startReceive();
 }
 
 void NetworkServer::handleReceive(const asio::error_code &error, std::size_t bytes_transferred)
 {
     if (!error && bytes_transferred > 0)
     {
-        std::vector<uint8_t> data(recv_buffer_.begin(), recv_buffer_.begin() + bytes_transferred);
-        handleMessage(data, sender_endpoint_);
+        // Decoded in place, recv_buffer_ isn't reused before handleMessage returns
+        handleDatagram(std::span<const uint8_t>(recv_buffer_.data(), bytes_transferred), sender_endpoint_);
     } else
     {
         std::cerr << "Error receiving message: " << error.message() << std::endl;
@@ -95,8 +173,20 @@ void NetworkServer::handleReceive(const asio::error_code &error, std::size_t byt
     startReceive();  // Continue receiving
 }
 
+void NetworkServer::handleDatagram(std::span<const uint8_t> data, const asio::ip::udp::endpoint &sender_endpoint)
+{
+    // The deserializers throw on a truncated message, nothing above the strand would catch it
+    try
+    {
+        handleMessage(data, sender_endpoint);
+    } catch (const std::runtime_error &e)
+    {
+        std::cerr << "Dropped malformed message from " << sender_endpoint << ": " << e.what() << std::endl;
+    }
+}
+
 // Process the received message (from client)
-void NetworkServer::handleMessage(const std::vector<uint8_t> &data, const asio::ip::udp::endpoint &sender_endpoint)
+void NetworkServer::handleMessage(std::span<const uint8_t> data, const asio::ip::udp::endpoint &sender_endpoint)
 {
     MessageHeader header;
     deserializeMessageHeader(data, header);  // get teh message type and size
@@ -120,29 +210,110 @@ void NetworkServer::handleMessage(const std::vector<uint8_t> &data, const asio::
         case MessageType::UserInput: {
             UserInputMessage userInputMsg;
             deserializeUserInputMessage(data, userInputMsg);
-            handleUserInput(userInputMsg);
+            if (acceptInput(userInputMsg))
+                handleUserInput(userInputMsg);
+            break;
+        }
+        case MessageType::SnapshotAck: {
+            SnapshotAckMessage ackMsg;
+            deserializeSnapshotAckMessage(data, ackMsg);
+            handleSnapshotAck(ackMsg);
+            break;
+        }
+        case MessageType::Reliable: {
+            ReliableView reliableMsg;
+            deserializeReliableMessage(data, reliableMsg);
+            handleReliable(reliableMsg, sender_endpoint);
             break;
         }
         default: std::cerr << "Unknown message type received: " << header.messageType << std::endl; break;
     }
 }
 
+// Handle a message of a client's reliable channel: ack it, then handle the control messages it made ready, in order
+void NetworkServer::handleReliable(const ReliableView &msg, const asio::ip::udp::endpoint &sender_endpoint)
+{
+    auto found = _control.find(msg.clientId);
+
+    // A message with a sequence carries a control message, at least its header
+    if (msg.sequence != 0 && msg.payload.size() < sizeof(MessageHeader))
+        return;
+
+    if (found == _control.end())
+    {
+        if (msg.sequence == 0)
+            return;
+
+        // Only a connect opens a channel, anything else was resent to a closed one: acked so it isn't resent forever
+        MessageHeader header;
+        deserializeMessageHeader(msg.payload, header);
+        if (static_cast<MessageType>(header.messageType) != MessageType::Connect)
+        {
+            ReliableMessage ackMsg = {
+                {static_cast<uint16_t>(MessageType::Reliable), RELIABLE_HEADER_SIZE},
+                msg.clientId, 0, msg.sequence, 0, {}
+            };
+            sendReliable(ackMsg, {}, sender_endpoint);
+            return;
+        }
+        found = _control.emplace(msg.clientId, ControlChannel()).first;
+    }
+
+    ControlChannel &control = found->second;
+    bool disconnected = false;
+
+    touchClient(msg.clientId);
+    control.endpoint = sender_endpoint;
+    control.channel.acknowledge(msg.ack, msg.ackBits);
+    bool received = control.channel.receive(msg.sequence, msg.payload, [&](std::span<const uint8_t> message) {
+        MessageHeader header;
+        deserializeMessageHeader(message, header);
+        switch (static_cast<MessageType>(header.messageType))
+        {
+            case MessageType::Reliable: return;  // Never nested
+            case MessageType::Disconnect: disconnected = true; break;
+            default: break;
+        }
+        // Caught per message, the ones after it in the channel are still handled
+        handleDatagram(message, sender_endpoint);
+    });
+    if (!received)
+        return;
+
+    ReliableMessage ackMsg = {
+        {static_cast<uint16_t>(MessageType::Reliable), RELIABLE_HEADER_SIZE},
+        msg.clientId, 0, msg.sequence, control.channel.ackBits(msg.sequence), {}
+    };
+    sendReliable(ackMsg, {}, sender_endpoint);
+    // Closed once its disconnect is acked, its resends get acked by the code above
+    if (disconnected)
+        _control.erase(found);
+}
+
 // Handle a connection request
 void NetworkServer::handleConnect(const ConnectMessage &msg, const asio::ip::udp::endpoint &endpoint)
 {
     std::cout << "Client connected with ID: " << msg.clientId << " from " << endpoint << std::endl;
 
+    // Seat the client, its room's channel is opened along with the room
+    std::shared_ptr<Room> room = _rooms.join(msg.clientId);
+    if (!room)
+    {
+        std::cerr << "No room available for client ID: " << msg.clientId << std::endl;
+        return;
+    }
+
     // Store the client's endpoint
-    clients_[msg.clientId] = endpoint;
+    RoomClient &client = _channels.at(room->id())->clients[msg.clientId];
+    client.endpoint = endpoint;
+    client.lastReceived = Clock::now();
 
     // Send a connection acknowledgment back to the client (let client know)
     ConnectMessage ackMsg = {
         {static_cast<uint16_t>(MessageType::Connect), sizeof(ConnectMessage)},
         msg.clientId
     };
-    std::vector<uint8_t> buffer;
-    serializeConnectMessage(ackMsg, buffer);
-    sendMessage(buffer, endpoint);  // back to client the connect succesful..
+    sendControl(msg.clientId, endpoint, ackMsg, serializeConnectMessage);  // back to client the connect succesful..
 }
 
 // Handle a disconnect request
@@ -150,8 +321,74 @@ void NetworkServer::handleDisconnect(const DisconnectMessage &msg, const asio::i
 {
     std::cout << "Client disconnected with ID: " << msg.clientId << " from " << endpoint << std::endl;
 
-    // Remove the client from the map
-    clients_.erase(msg.clientId);
+    // Remove the client from its room
+    std::shared_ptr<Room> room = _rooms.leave(msg.clientId);
+    if (!room)
+        return;
+
+    auto channel = _channels.find(room->id());
+    if (channel != _channels.end())
+        channel->second->clients.erase(msg.clientId);
+}
+
+void NetworkServer::dropClient(uint32_t clientId, const asio::ip::udp::endpoint &endpoint)
+{
+    DisconnectMessage msg = {
+        {static_cast<uint16_t>(MessageType::Disconnect), sizeof(DisconnectMessage)},
+        clientId
+    };
+    handleDisconnect(msg, endpoint);
+}
+
+void NetworkServer::touchClient(uint32_t clientId)
+{
+    RoomChannel *channel = findChannel(clientId);
+    if (channel == nullptr)
+        return;
+
+    auto client = channel->clients.find(clientId);
+    if (client != channel->clients.end())
+        client->second.lastReceived = Clock::now();
+}
+
+// The reliable channel only expires with a message unacked, an idle client is caught by the datagrams it stops sending
+void NetworkServer::expireClients()
+{
+    Clock::time_point deadline = Clock::now() - std::chrono::milliseconds(CLIENT_TIMEOUT_MS);
+    std::vector<std::pair<uint32_t, asio::ip::udp::endpoint>> expired;
+
+    for (auto &[roomId, channel] : _channels)
+    {
+        for (auto &[clientId, client] : channel->clients)
+        {
+            if (client.lastReceived < deadline)
+                expired.emplace_back(clientId, client.endpoint);
+        }
+    }
+    for (const auto &[clientId, endpoint] : expired)
+    {
+        std::cerr << "Client ID: " << clientId << " timed out" << std::endl;
+        _control.erase(clientId);
+        dropClient(clientId, endpoint);
+    }
+}
+
+// Handle a snapshot ack, the next snapshots for this client are sent relative to it
+void NetworkServer::handleSnapshotAck(const SnapshotAckMessage &msg)
+{
+    RoomChannel *channel = findChannel(msg.clientId);
+    if (channel == nullptr || msg.sequence > channel->snapshots.latestSequence())
+        return;
+
+    auto client = channel->clients.find(msg.clientId);
+    if (client == channel->clients.end())
+        return;
+
+    client->second.lastReceived = Clock::now();
+
+    // Acks may arrive out of order, only move forward
+    uint32_t &acked = client->second.ackedSequence;
+    acked = std::max(acked, msg.sequence);
 }
 
 // Handle user input from a client
@@ -171,31 +408,297 @@ void NetworkServer::handleUserInput(const UserInputMessage &msg)
     // TODO: Pass input to the ECS system and other inputs to be processed
 }
 
+// Rate limits the inputs of a client, on the strand
+bool NetworkServer::acceptInput(const UserInputMessage &msg)
+{
+    // Only the sequenced commands are limited: the lobby inputs come on the reliable channel, which already acked them
+    if (msg.sequence == 0)
+        return true;
+
+    RoomChannel *channel = findChannel(msg.clientId);
+    if (channel == nullptr)
+        return true;
+
+    auto client = channel->clients.find(msg.clientId);
+    if (client == channel->clients.end())
+        return true;
+
+    // A message repeats the commands before its own, one that isn't newer than the last forwarded brings nothing new
+    RoomClient &sender = client->second;
+    Clock::time_point now = Clock::now();
+    sender.lastReceived = now;
+    if (msg.sequence <= sender.inputSequence)
+        return false;
+
+    // Token bucket, refilled at INPUT_MESSAGE_RATE up to INPUT_MESSAGE_BURST
+    std::chrono::duration<float> elapsed = now - sender.inputRefill;
+    sender.inputTokens = std::min(INPUT_MESSAGE_BURST, sender.inputTokens + elapsed.count() * INPUT_MESSAGE_RATE);
+    sender.inputRefill = now;
+    if (sender.inputTokens < 1.0f)
+        return false;
+
+    sender.inputTokens -= 1.0f;
+    sender.inputSequence = msg.sequence;
+    return true;
+}
+
 // Placeholder for updating the game state
 void NetworkServer::updateGameState()
 {
     // TODO: Implement ECS logic
 }
 
-// Placeholder for sending the game state to all clients
-void NetworkServer::sendGameState(const StateUpdateMessage &stateMsg)
+// Send the game state to the clients of a room
+void NetworkServer::sendGameState(RoomChannel &channel, const StateUpdateMessage &stateMsg)
 {
-    // Serialize the stateMsg into a buffer
-    std::vector<uint8_t> buffer;
-    serializeStateUpdateMessage(stateMsg, buffer);
+    static const std::vector<EntityState> emptySnapshot;
+    uint32_t sequence = channel.snapshots.push(stateMsg.entities);
+    const std::vector<EntityState> &current = *channel.snapshots.find(sequence);
 
-    // Send to all clients
-    for (const auto &[clientId, endpoint] : clients_)
+    // Clients that acked the same shared baseline get the same datagrams, built once (baseSequence -> datagrams)
+    std::vector<std::pair<uint32_t, Datagrams>> &deltas = _sharedDeltas;
+
+    for (auto &[clientId, client] : channel.clients)
     {
-        sendMessage(buffer, endpoint);
+        const asio::ip::udp::endpoint &endpoint = client.endpoint;
+        uint32_t baseSequence = client.ackedSequence;
+
+        queueInputAck(client, clientId, stateMsg);
+        // If that snapshot was trimmed for this client, the baseline is what it rebuilt, not the full snapshot
+        const std::vector<EntityState> *base = client.trimmed.find(baseSequence);
+        bool sharedBase = (base == nullptr);
+
+        if (sharedBase)
+            base = channel.snapshots.find(baseSequence);
+        // Never acked or acked too long ago: relative to nothing, every entity is created
+        if (base == nullptr)
+            baseSequence = 0;
+
+        auto cached = std::find_if(deltas.begin(), deltas.end(),
+                                   [baseSequence](const auto &delta) { return delta.first == baseSequence; });
+        if (sharedBase && cached != deltas.end())
+        {
+            sendDatagrams(cached->second, endpoint);
+            continue;
+        }
+
+        _delta.header = {static_cast<uint16_t>(MessageType::DeltaStateUpdate), 0};
+        _delta.sequence = sequence;
+        _delta.baseSequence = baseSequence;
+        diffSnapshots(base ? *base : emptySnapshot, current, _delta);
+
+        Datagrams datagrams;
+        if (serializedDeltaStateUpdateSize(_delta) <= MAX_SNAPSHOT_SIZE)
+        {
+            buildDatagrams(_delta, datagrams);
+        } else
+        {
+            // Over the budget: send what matters most to this client, the rest stays in its next deltas
+            packDelta(_delta, current, clientId, MAX_SNAPSHOT_SIZE, _packed);
+            buildDatagrams(_packed, datagrams);
+            applyDelta(base ? *base : emptySnapshot, _packed, _rebuilt);
+            client.trimmed.store(sequence, _rebuilt);
+            sharedBase = false;
+        }
+        sendDatagrams(datagrams, endpoint);
+        // Shared ones are kept for the next clients, until every client got its delta
+        if (sharedBase)
+            deltas.emplace_back(baseSequence, datagrams);
+        else
+            releaseDatagrams(datagrams);
+    }
+
+    // Every client's datagrams at once
+    flushDatagrams();
+    for (auto &delta : deltas)
+        releaseDatagrams(delta.second);
+    deltas.clear();
+}
+
+void NetworkServer::queueInputAck(RoomClient &client, uint32_t clientId, const StateUpdateMessage &stateMsg)
+{
+    auto ack = std::find_if(stateMsg.inputAcks.begin(), stateMsg.inputAcks.end(),
+                            [clientId](const InputAckMessage &inputAck) { return inputAck.clientId == clientId; });
+    if (ack == stateMsg.inputAcks.end())
+        return;
+
+    if (ack->sequence != client.inputAck.sequence || ack->posX != client.inputAck.posX ||
+        ack->posY != client.inputAck.posY)
+    {
+        client.inputAck = *ack;
+        client.inputAckSends = INPUT_ACK_SENDS;
     }
+    if (client.inputAckSends == 0)
+        return;
+    --client.inputAckSends;
+
+    SendBufferPool::Buffer *buffer = _sendBuffers.acquire();
+    SpanWriter writer = buffer->writer();
+
+    serializeInputAckMessage(client.inputAck, writer);
+    buffer->size = writer.size();
+    // Sent along the deltas by flushDatagrams, which releases it
+    _outgoing.push_back({buffer, client.endpoint});
+}
+
+void NetworkServer::buildDatagrams(const DeltaStateUpdateMessage &delta, Datagrams &datagrams)
+{
+    datagrams.count = 0;
+
+    if (serializedDeltaStateUpdateSize(delta) <= MAX_DATAGRAM_SIZE)
+    {
+        SendBufferPool::Buffer *buffer = _sendBuffers.acquire();
+        SpanWriter writer = buffer->writer();
+
+        serializeDeltaStateUpdateMessage(delta, writer);
+        buffer->size = writer.size();
+        datagrams.buffers[datagrams.count++] = buffer;
+        return;
+    }
+
+    SpanWriter serialized(_serialized);
+    serializeDeltaStateUpdateMessage(delta, serialized);
+
+    // The client puts the message back together once it got every fragment of the group
+    FragmentMessage fragment;
+    fragment.header = {static_cast<uint16_t>(MessageType::Fragment), 0};
+    fragment.groupId = ++_fragmentGroup;
+    size_t fragmentCount = (serialized.size() + MAX_FRAGMENT_PAYLOAD - 1) / MAX_FRAGMENT_PAYLOAD;
+    fragment.fragmentCount = static_cast<uint8_t>(fragmentCount);
+    for (size_t offset = 0; offset < serialized.size(); offset += MAX_FRAGMENT_PAYLOAD)
+    {
+        size_t end = std::min(offset + MAX_FRAGMENT_PAYLOAD, serialized.size());
+        SendBufferPool::Buffer *buffer = _sendBuffers.acquire();
+        SpanWriter writer = buffer->writer();
+
+        fragment.fragmentIndex = static_cast<uint8_t>(offset / MAX_FRAGMENT_PAYLOAD);
+        serializeFragmentMessage(fragment, std::span<const uint8_t>(_serialized.data() + offset, end - offset),
+                                 writer);
+        buffer->size = writer.size();
+        datagrams.buffers[datagrams.count++] = buffer;
+    }
+}
+
+void NetworkServer::sendDatagrams(const Datagrams &datagrams, const asio::ip::udp::endpoint &target_endpoint)
+{
+    for (size_t i = 0; i < datagrams.count; ++i)
+    {
+        _sendBuffers.retain(datagrams.buffers[i]);
+        _outgoing.push_back({datagrams.buffers[i], target_endpoint});
+    }
+}
+
+void NetworkServer::flushDatagrams()
+{
+    size_t sent = 0;
+
+#ifdef SERVER_BATCH_IO
+    asio::error_code error;
+    sent = _batch.send(_outgoing, error);
+    for (size_t i = 0; i < sent; ++i)
+        _sendBuffers.release(_outgoing[i].buffer);
+#endif
+    // What couldn't be sent right away goes through asio, which waits for the socket to be writable
+    for (size_t i = sent; i < _outgoing.size(); ++i)
+    {
+        sendMessage(_outgoing[i].buffer, _outgoing[i].endpoint);
+        _sendBuffers.release(_outgoing[i].buffer);
+    }
+    _outgoing.clear();
+}
+
+void NetworkServer::releaseDatagrams(Datagrams &datagrams)
+{
+    for (size_t i = 0; i < datagrams.count; ++i)
+        _sendBuffers.release(datagrams.buffers[i]);
+    datagrams.count = 0;
+}
+
+template <typename Message, typename Serialize>
+void NetworkServer::sendMessage(const Message &msg, Serialize serialize, const asio::ip::udp::endpoint &target_endpoint)
+{
+    SendBufferPool::Buffer *buffer = _sendBuffers.acquire();
+    SpanWriter writer = buffer->writer();
+
+    serialize(msg, writer);
+    buffer->size = writer.size();
+    sendMessage(buffer, target_endpoint);
+    _sendBuffers.release(buffer);
 }
 
 // Send a message to a specific client (to the target endpoint)
-void NetworkServer::sendMessage(const std::vector<uint8_t> &data, const asio::ip::udp::endpoint &target_endpoint)
+void NetworkServer::sendMessage(SendBufferPool::Buffer *buffer, const asio::ip::udp::endpoint &target_endpoint)
 {
-    socket_.async_send_to(asio::buffer(data), target_endpoint,
-                          [](const asio::error_code & /*error*/, std::size_t /*bytes_transferred*/) {
+    // The completion runs on the strand too, the pool is only touched there
+    _sendBuffers.retain(buffer);
+    socket_.async_send_to(asio::buffer(buffer->bytes.data(), buffer->size), target_endpoint,
+                          asio::bind_executor(_strand, [this, buffer](const asio::error_code & /*error*/,
+                                                                      std::size_t /*bytes_transferred*/) {
         // Handle errors if necessary
+        _sendBuffers.release(buffer);
+    }));
+}
+
+template <typename Message, typename Serialize>
+void NetworkServer::sendControl(uint32_t clientId, const asio::ip::udp::endpoint &endpoint, const Message &msg,
+                                Serialize serialize)
+{
+    ControlChannel &control = _control[clientId];
+    std::array<uint8_t, MAX_DATAGRAM_SIZE - RELIABLE_HEADER_SIZE> bytes;
+    SpanWriter writer(bytes);
+
+    serialize(msg, writer);
+    control.endpoint = endpoint;
+    control.channel.push(std::span<const uint8_t>(writer.data(), writer.size()));
+    flushControl(clientId, control);
+}
+
+void NetworkServer::flushControl(uint32_t clientId, ControlChannel &control)
+{
+    ReliableChannel &channel = control.channel;
+
+    channel.resend(ReliableChannel::Clock::now(), [&](uint32_t sequence, std::span<const uint8_t> message) {
+        ReliableMessage reliableMsg = {
+            {static_cast<uint16_t>(MessageType::Reliable), 0},
+            clientId, sequence, channel.lastReceived(), channel.ackBits(channel.lastReceived()), {}
+        };
+        sendReliable(reliableMsg, message, control.endpoint);
     });
 }
+
+void NetworkServer::startControlTimer()
+{
+    _controlTimer.expires_after(std::chrono::milliseconds(RELIABLE_RESEND_MS));
+    _controlTimer.async_wait(asio::bind_executor(_strand, [this](const asio::error_code &error) {
+        if (error)
+            return;
+        for (auto control = _control.begin(); control != _control.end();)
+        {
+            // Gone without a disconnect, nothing will ever ack its messages
+            if (control->second.channel.expired(ReliableChannel::Clock::now()))
+            {
+                uint32_t clientId = control->first;
+                asio::ip::udp::endpoint endpoint = control->second.endpoint;
+
+                std::cerr << "Client ID: " << clientId << " stopped acking, reliable channel closed" << std::endl;
+                control = _control.erase(control);
+                dropClient(clientId, endpoint);
+                continue;
+            }
+            flushControl(control->first, control->second);
+            ++control;
+        }
+        expireClients();
+        startControlTimer();
+    }));
+}
+
+void NetworkServer::sendReliable(const ReliableMessage &msg, std::span<const uint8_t> payload,
+                                 const asio::ip::udp::endpoint &target_endpoint)
+{
+    auto serialize = [payload](const ReliableMessage &reliableMsg, SpanWriter &writer) {
+        serializeReliableMessage(reliableMsg, payload, writer);
+    };
+
+    sendMessage(msg, serialize, target_endpoint);
+}
@@ -1,77 +1,335 @@
 #include "Protocol.hpp"
+#include "BitStream.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <stdexcept>
 
 using namespace server;
 
-// Serialize the common message header (header and buffer)
-void server::serializeMessageHeader(const MessageHeader &header, std::vector<uint8_t> &buffer)
+// Reads the raw bytes of value at offset and moves past them
+template <typename T>
+static void readBytes(std::span<const uint8_t> buffer, size_t &offset, T &value, const char *error)
+{
+    if (offset + sizeof(T) > buffer.size())
+        throw std::runtime_error(error);
+    memcpy(&value, buffer.data() + offset, sizeof(T));
+    offset += sizeof(T);
+}
+
+static bool hasField(uint8_t fieldMask, EntityField field)
+{
+    return (fieldMask & static_cast<uint8_t>(field)) != 0;
+}
+
+// Fixed point position, clamped to the WIRE_POS_BITS window starting at min
+static uint32_t quantizePosition(float value, float min)
 {
-    // insert -> pos, the firstm and last (is type + size of type...) reintrpret pointer to be uint8_t pointer to have [(byte1, byte2), (byte3, byte4)] type and size
-    uint16_t type = htons(header.messageType);
-    uint16_t size = htons(header.messageSize);
+    long limit = (1L << WIRE_POS_BITS) - 1;
 
-    // we crete a buffer with the data -> we first insert the type and then the size
-    buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&type),
-                  reinterpret_cast<const uint8_t *>(&type) + sizeof(type));
+    return static_cast<uint32_t>(std::clamp(std::lround((value - min) * WIRE_FIXED_SCALE), 0L, limit));
+}
 
-    buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&size),
-                  reinterpret_cast<const uint8_t *>(&size) + sizeof(size));
+static float dequantizePosition(uint32_t value, float min)
+{
+    return min + static_cast<float>(value) / WIRE_FIXED_SCALE;
+}
+
+// Fixed point velocity, two's complement on WIRE_VEL_BITS
+static uint32_t quantizeVelocity(float value)
+{
+    long limit = 1L << (WIRE_VEL_BITS - 1);
+    long fixed = std::clamp(std::lround(value * WIRE_FIXED_SCALE), -limit, limit - 1);
+
+    return static_cast<uint32_t>(fixed) & ((1u << WIRE_VEL_BITS) - 1);
+}
+
+static float dequantizeVelocity(uint32_t value)
+{
+    // Sign extends from WIRE_VEL_BITS
+    int32_t fixed = static_cast<int32_t>(value << (32 - WIRE_VEL_BITS)) >> (32 - WIRE_VEL_BITS);
+
+    return static_cast<float>(fixed) / WIRE_FIXED_SCALE;
+}
+
+// Created entity after its id: type, health, position, velocity, then clientId for players only
+static void writeCreatedEntity(BitWriter &writer, const EntityState &state)
+{
+    writer.write(static_cast<uint32_t>(state.entityType), WIRE_TYPE_BITS);
+    writer.write(state.health, WIRE_HEALTH_BITS);
+    writer.write(quantizePosition(state.posX, WIRE_POS_MIN_X), WIRE_POS_BITS);
+    writer.write(quantizePosition(state.posY, WIRE_POS_MIN_Y), WIRE_POS_BITS);
+    writer.write(quantizeVelocity(state.velX), WIRE_VEL_BITS);
+    writer.write(quantizeVelocity(state.velY), WIRE_VEL_BITS);
+    if (state.entityType == EntityType::PLAYER)
+        writer.write(state.clientId, 32);
+}
+
+static void readCreatedEntity(BitReader &reader, EntityState &state)
+{
+    state.entityType = static_cast<EntityType>(reader.read(WIRE_TYPE_BITS));
+    state.health = static_cast<uint8_t>(reader.read(WIRE_HEALTH_BITS));
+    state.posX = dequantizePosition(reader.read(WIRE_POS_BITS), WIRE_POS_MIN_X);
+    state.posY = dequantizePosition(reader.read(WIRE_POS_BITS), WIRE_POS_MIN_Y);
+    state.velX = dequantizeVelocity(reader.read(WIRE_VEL_BITS));
+    state.velY = dequantizeVelocity(reader.read(WIRE_VEL_BITS));
+    state.clientId = (state.entityType == EntityType::PLAYER) ? reader.read(32) : NO_CLIENT_ID;
+}
+
+// Updated entity after its id: field mask, then only the fields set in the mask
+static void writeUpdatedEntity(BitWriter &writer, const EntityDelta &delta)
+{
+    const EntityState &state = delta.state;
+
+    writer.write(delta.fieldMask, WIRE_FIELD_MASK_BITS);
+    if (hasField(delta.fieldMask, EntityField::ClientId))
+        writer.write(state.clientId, 32);
+    if (hasField(delta.fieldMask, EntityField::PosX))
+        writer.write(quantizePosition(state.posX, WIRE_POS_MIN_X), WIRE_POS_BITS);
+    if (hasField(delta.fieldMask, EntityField::PosY))
+        writer.write(quantizePosition(state.posY, WIRE_POS_MIN_Y), WIRE_POS_BITS);
+    if (hasField(delta.fieldMask, EntityField::VelX))
+        writer.write(quantizeVelocity(state.velX), WIRE_VEL_BITS);
+    if (hasField(delta.fieldMask, EntityField::VelY))
+        writer.write(quantizeVelocity(state.velY), WIRE_VEL_BITS);
+    if (hasField(delta.fieldMask, EntityField::EntityType))
+        writer.write(static_cast<uint32_t>(state.entityType), WIRE_TYPE_BITS);
+    if (hasField(delta.fieldMask, EntityField::Health))
+        writer.write(state.health, WIRE_HEALTH_BITS);
+}
+
+static void readUpdatedEntity(BitReader &reader, EntityDelta &delta)
+{
+    EntityState &state = delta.state;
+
+    delta.fieldMask = static_cast<uint8_t>(reader.read(WIRE_FIELD_MASK_BITS));
+    if (hasField(delta.fieldMask, EntityField::ClientId))
+        state.clientId = reader.read(32);
+    if (hasField(delta.fieldMask, EntityField::PosX))
+        state.posX = dequantizePosition(reader.read(WIRE_POS_BITS), WIRE_POS_MIN_X);
+    if (hasField(delta.fieldMask, EntityField::PosY))
+        state.posY = dequantizePosition(reader.read(WIRE_POS_BITS), WIRE_POS_MIN_Y);
+    if (hasField(delta.fieldMask, EntityField::VelX))
+        state.velX = dequantizeVelocity(reader.read(WIRE_VEL_BITS));
+    if (hasField(delta.fieldMask, EntityField::VelY))
+        state.velY = dequantizeVelocity(reader.read(WIRE_VEL_BITS));
+    if (hasField(delta.fieldMask, EntityField::EntityType))
+        state.entityType = static_cast<EntityType>(reader.read(WIRE_TYPE_BITS));
+    if (hasField(delta.fieldMask, EntityField::Health))
+        state.health = static_cast<uint8_t>(reader.read(WIRE_HEALTH_BITS));
+}
+
+// Serialize the common message header (header and buffer)
+void server::serializeMessageHeader(const MessageHeader &header, SpanWriter &writer)
+{
+    // htons is int to bytes, the type first and then the size
+    writer.write(htons(header.messageType));
+    writer.write(htons(header.messageSize));
 }
 
 // Serialize ConnectMessage
-void server::serializeConnectMessage(const ConnectMessage &msg, std::vector<uint8_t> &buffer)
+void server::serializeConnectMessage(const ConnectMessage &msg, SpanWriter &writer)
 {
-    server::serializeMessageHeader(msg.header, buffer);
+    server::serializeMessageHeader(msg.header, writer);
 
-    uint32_t clientId = htonl(msg.clientId);
-    buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&clientId),
-                  reinterpret_cast<const uint8_t *>(&clientId) + sizeof(clientId));
+    writer.write(htonl(msg.clientId));
 }
 
 // Serialize DisconnectMessage
-void server::serializeDisconnectMessage(const DisconnectMessage &msg, std::vector<uint8_t> &buffer)
+void server::serializeDisconnectMessage(const DisconnectMessage &msg, SpanWriter &writer)
 {
-    server::serializeMessageHeader(msg.header, buffer);
+    server::serializeMessageHeader(msg.header, writer);
 
-    // we use equivalent to pushback.. always insert at the end
-    uint32_t clientId = htonl(msg.clientId);
-    buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&clientId),
-                  reinterpret_cast<const uint8_t *>(&clientId) + sizeof(clientId));
+    writer.write(htonl(msg.clientId));
 }
 
-void server::serializeGameOverMessage(const GameOverMessage &msg, std::vector<uint8_t> &buffer)
+void server::serializeGameOverMessage(const GameOverMessage &msg, SpanWriter &writer)
 {
     // First serialize the common message header (4 bytes total)
-    server::serializeMessageHeader(msg.header, buffer);
+    server::serializeMessageHeader(msg.header, writer);
 
-    uint32_t netClientId = htonl(msg.clientId);
-    buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&netClientId),
-                  reinterpret_cast<const uint8_t *>(&netClientId) + sizeof(netClientId));
+    writer.write(htonl(msg.clientId));
+    writer.write(htons(static_cast<uint16_t>(msg.condition)));
+}
+
+// Serialize InputAckMessage, the position is sent as the bits of the floats
+void server::serializeInputAckMessage(const InputAckMessage &msg, SpanWriter &writer)
+{
+    server::serializeMessageHeader(msg.header, writer);
 
-    uint16_t netCondition = htons(static_cast<uint16_t>(msg.condition));
-    buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&netCondition),
-                  reinterpret_cast<const uint8_t *>(&netCondition) + sizeof(netCondition));
+    writer.write(htonl(msg.clientId));
+    writer.write(htonl(msg.sequence));
+    writer.write(htonl(std::bit_cast<uint32_t>(msg.posX)));
+    writer.write(htonl(std::bit_cast<uint32_t>(msg.posY)));
 }
 
 // Serialize StateUpdateMessage
-void server::serializeStateUpdateMessage(const StateUpdateMessage &msg, std::vector<uint8_t> &buffer)
+void server::serializeStateUpdateMessage(const StateUpdateMessage &msg, SpanWriter &writer)
+{
+    server::serializeMessageHeader(msg.header, writer);
+
+    writer.write(htonl(msg.numEntities));
+    writer.writeBytes(msg.entities.data(), msg.entities.size() * sizeof(EntityState));
+}
+
+// Serialize DeltaStateUpdateMessage, the size in the header is computed from what was written
+void server::serializeDeltaStateUpdateMessage(const DeltaStateUpdateMessage &msg, SpanWriter &writer)
 {
-    server::serializeMessageHeader(msg.header, buffer);
+    size_t start = writer.size();
+    server::serializeMessageHeader(msg.header, writer);
+
+    writer.write(htonl(msg.sequence));
+    writer.write(htonl(msg.baseSequence));
+    writer.write(htons(static_cast<uint16_t>(msg.created.size())));
+    writer.write(htons(static_cast<uint16_t>(msg.updated.size())));
+    writer.write(htons(static_cast<uint16_t>(msg.destroyed.size())));
+
+    // Bit-packed body, each list is sorted by id so only the gap from the previous id is written
+    BitWriter bits(writer);
+    uint32_t previousId = 0;
+    for (const auto &entity : msg.created)
+    {
+        bits.writeVarint(entity.entityId - previousId);
+        writeCreatedEntity(bits, entity);
+        previousId = entity.entityId;
+    }
+    previousId = 0;
+    for (const auto &delta : msg.updated)
+    {
+        bits.writeVarint(delta.state.entityId - previousId);
+        writeUpdatedEntity(bits, delta);
+        previousId = delta.state.entityId;
+    }
+    previousId = 0;
+    for (uint32_t entityId : msg.destroyed)
+    {
+        bits.writeVarint(entityId - previousId);
+        previousId = entityId;
+    }
+    bits.flush();
 
-    uint32_t numEntities = htonl(msg.numEntities);
-    buffer.insert(buffer.end(),
-                  reinterpret_cast<const uint8_t *>(
-                      &numEntities),  // start the position of the ponter num entities an den that + the size
-                  reinterpret_cast<const uint8_t *>(&numEntities) + sizeof(numEntities));
+    // Patch the real message size in the header
+    uint16_t size = htons(static_cast<uint16_t>(writer.size() - start));
+    memcpy(writer.data() + start + sizeof(uint16_t), &size, sizeof(size));
+}
 
-    for (const auto &entity : msg.entities)
+void server::quantizeEntityState(EntityState &state)
+{
+    state.posX = dequantizePosition(quantizePosition(state.posX, WIRE_POS_MIN_X), WIRE_POS_MIN_X);
+    state.posY = dequantizePosition(quantizePosition(state.posY, WIRE_POS_MIN_Y), WIRE_POS_MIN_Y);
+    state.velX = dequantizeVelocity(quantizeVelocity(state.velX));
+    state.velY = dequantizeVelocity(quantizeVelocity(state.velY));
+    if (state.entityType != EntityType::PLAYER)
+        state.clientId = NO_CLIENT_ID;
+}
+
+size_t server::createdEntityBits(const EntityState &state)
+{
+    size_t bits = varintBits(state.entityId) + WIRE_TYPE_BITS + WIRE_HEALTH_BITS;
+
+    bits += 2 * WIRE_POS_BITS + 2 * WIRE_VEL_BITS;
+    if (state.entityType == EntityType::PLAYER)
+        bits += 32;
+    return bits;
+}
+
+size_t server::updatedEntityBits(const EntityDelta &delta)
+{
+    size_t bits = varintBits(delta.state.entityId) + WIRE_FIELD_MASK_BITS;
+
+    if (hasField(delta.fieldMask, EntityField::ClientId))
+        bits += 32;
+    if (hasField(delta.fieldMask, EntityField::PosX))
+        bits += WIRE_POS_BITS;
+    if (hasField(delta.fieldMask, EntityField::PosY))
+        bits += WIRE_POS_BITS;
+    if (hasField(delta.fieldMask, EntityField::VelX))
+        bits += WIRE_VEL_BITS;
+    if (hasField(delta.fieldMask, EntityField::VelY))
+        bits += WIRE_VEL_BITS;
+    if (hasField(delta.fieldMask, EntityField::EntityType))
+        bits += WIRE_TYPE_BITS;
+    if (hasField(delta.fieldMask, EntityField::Health))
+        bits += WIRE_HEALTH_BITS;
+    return bits;
+}
+
+size_t server::serializedDeltaStateUpdateSize(const DeltaStateUpdateMessage &msg)
+{
+    size_t bits = 0;
+    uint32_t previousId = 0;
+
+    // Same id gaps as serializeDeltaStateUpdateMessage, so the size is exact
+    for (const auto &entity : msg.created)
     {
-        buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&entity),
-                      reinterpret_cast<const uint8_t *>(&entity) + sizeof(EntityState));
+        bits += createdEntityBits(entity) - varintBits(entity.entityId) + varintBits(entity.entityId - previousId);
+        previousId = entity.entityId;
     }
+    previousId = 0;
+    for (const auto &delta : msg.updated)
+    {
+        uint32_t entityId = delta.state.entityId;
+
+        bits += updatedEntityBits(delta) - varintBits(entityId) + varintBits(entityId - previousId);
+        previousId = entityId;
+    }
+    previousId = 0;
+    for (uint32_t entityId : msg.destroyed)
+    {
+        bits += varintBits(entityId - previousId);
+        previousId = entityId;
+    }
+    return DELTA_STATE_UPDATE_HEADER_SIZE + (bits + 7) / 8;
+}
+
+// Serialize FragmentMessage, the size in the header is computed from the payload
+void server::serializeFragmentMessage(const FragmentMessage &msg, SpanWriter &writer)
+{
+    serializeFragmentMessage(msg, msg.payload, writer);
+}
+
+void server::serializeFragmentMessage(const FragmentMessage &msg, std::span<const uint8_t> payload, SpanWriter &writer)
+{
+    MessageHeader header = {msg.header.messageType, static_cast<uint16_t>(FRAGMENT_HEADER_SIZE + payload.size())};
+
+    server::serializeMessageHeader(header, writer);
+
+    writer.write(htonl(msg.groupId));
+    writer.writeByte(msg.fragmentIndex);
+    writer.writeByte(msg.fragmentCount);
+    writer.writeBytes(payload.data(), payload.size());
+}
+
+// Serialize ReliableMessage, the size in the header is computed from the payload
+void server::serializeReliableMessage(const ReliableMessage &msg, SpanWriter &writer)
+{
+    serializeReliableMessage(msg, msg.payload, writer);
+}
+
+void server::serializeReliableMessage(const ReliableMessage &msg, std::span<const uint8_t> payload, SpanWriter &writer)
+{
+    MessageHeader header = {msg.header.messageType, static_cast<uint16_t>(RELIABLE_HEADER_SIZE + payload.size())};
+
+    server::serializeMessageHeader(header, writer);
+
+    writer.write(htonl(msg.clientId));
+    writer.write(htonl(msg.sequence));
+    writer.write(htonl(msg.ack));
+    writer.write(htonl(msg.ackBits));
+    writer.writeBytes(payload.data(), payload.size());
+}
+
+// Serialize SnapshotAckMessage
+void server::serializeSnapshotAckMessage(const SnapshotAckMessage &msg, SpanWriter &writer)
+{
+    server::serializeMessageHeader(msg.header, writer);
+
+    writer.write(htonl(msg.clientId));
+    writer.write(htonl(msg.sequence));
 }
 
 // !THIS IS A EXAMPLE FOR THE CLINENT
@@ -83,21 +341,20 @@ void server::serializeStateUpdateMessage(const StateUpdateMessage &msg, std::vec
 // inputMsg.clientId = clientId;
 // inputMsg.inputFlags = static_cast<uint8_t>(InputFlags::MoveUp) | static_cast<uint8_t>(InputFlags::Fire);
 
-void server::serializeUserInputMessage(const UserInputMessage &msg, std::vector<uint8_t> &buffer)
+void server::serializeUserInputMessage(const UserInputMessage &msg, SpanWriter &writer)
 {
-    server::serializeMessageHeader(msg.header, buffer);
+    server::serializeMessageHeader(msg.header, writer);
 
-    uint32_t clientId = htonl(msg.clientId);
-    buffer.insert(buffer.end(), reinterpret_cast<const uint8_t *>(&clientId),
-                  reinterpret_cast<const uint8_t *>(&clientId) + sizeof(clientId));
-
-    buffer.push_back(msg.inputFlags);
+    writer.write(htonl(msg.clientId));
+    writer.write(htonl(msg.sequence));
+    writer.writeByte(msg.inputFlags);
+    writer.writeBytes(msg.previousFlags, INPUT_REDUNDANCY);
 }
 
 // ! Deserialize the common message header -> used by the client and server
 
 // Deserialize MessageHeader
-void server::deserializeMessageHeader(const std::vector<uint8_t> &buffer, MessageHeader &header)
+void server::deserializeMessageHeader(std::span<const uint8_t> buffer, MessageHeader &header)
 {
     if (buffer.size() < sizeof(MessageHeader))
         throw std::runtime_error("Buffer too small for header");
@@ -110,7 +367,7 @@ void server::deserializeMessageHeader(const std::vector<uint8_t> &buffer, Messag
 
 // Deserialize ConnectMessage -> take the bytes and memcopp to the structe sru dta an sizeof the
 // the src is the startign point for that so the point  buffer + already filled
-void server::deserializeConnectMessage(const std::vector<uint8_t> &buffer, ConnectMessage &msg)
+void server::deserializeConnectMessage(std::span<const uint8_t> buffer, ConnectMessage &msg)
 {
     server::deserializeMessageHeader(buffer, msg.header);
 
@@ -123,7 +380,7 @@ void server::deserializeConnectMessage(const std::vector<uint8_t> &buffer, Conne
 }
 
 // Deserialize DisconnectMessage
-void server::deserializeDisconnectMessage(const std::vector<uint8_t> &buffer, DisconnectMessage &msg)
+void server::deserializeDisconnectMessage(std::span<const uint8_t> buffer, DisconnectMessage &msg)
 {
     server::deserializeMessageHeader(buffer, msg.header);
 
@@ -134,51 +391,53 @@ void server::deserializeDisconnectMessage(const std::vector<uint8_t> &buffer, Di
     msg.clientId = ntohl(msg.clientId);
 }
 
-// Deserialize StateUpdateMessage (CLIENT)
-void server::deserializeStateUpdateMessage(const std::vector<uint8_t> &buffer, StateUpdateMessage &msg)
+// Deserialize StateUpdateMessage (CLIENT), the entities are checked to fit in the buffer but not decoded
+void server::deserializeStateUpdateMessage(std::span<const uint8_t> buffer, StateUpdateView &view)
 {
-    server::deserializeMessageHeader(buffer, msg.header);
+    const char *error = "Buffer too small for StateUpdateMessage";
+    size_t offset = sizeof(MessageHeader);
 
-    if (buffer.size() < sizeof(MessageHeader) + sizeof(uint32_t))  // each state has the num of entites
-        throw std::runtime_error("Buffer too small for StateUpdateMessage");
+    server::deserializeMessageHeader(buffer, view.header);
 
-    memcpy(&msg.numEntities, buffer.data() + sizeof(MessageHeader), sizeof(uint32_t));
-    msg.numEntities = ntohl(msg.numEntities);
+    readBytes(buffer, offset, view.numEntities, error);
+    view.numEntities = ntohl(view.numEntities);
 
-    size_t offset = sizeof(MessageHeader) + sizeof(uint32_t);  // header + num of entiites
-    for (uint32_t i = 0; i < msg.numEntities; ++i)
-    {
-        if (offset + sizeof(EntityState) > buffer.size())
-            throw std::runtime_error("Buffer too small for EntityState");
+    size_t entitiesSize = size_t(view.numEntities) * sizeof(EntityState);
+    if (entitiesSize > buffer.size() - offset)
+        throw std::runtime_error("Buffer too small for EntityState");
+    view.entities = EntityStateRange(buffer.subspan(offset, entitiesSize));
+}
 
-        EntityState entity;
-        memcpy(&entity, buffer.data() + offset, sizeof(EntityState));
-        msg.entities.push_back(entity);  // push_back to the entities vector -> (will be client thing this)
-        offset += sizeof(EntityState);
-    }
+void server::deserializeStateUpdateMessage(std::span<const uint8_t> buffer, StateUpdateMessage &msg)
+{
+    StateUpdateView view;
+
+    server::deserializeStateUpdateMessage(buffer, view);
+    msg.header = view.header;
+    msg.numEntities = view.numEntities;
+    msg.entities.assign(view.entities.begin(), view.entities.end());
 }
 
 // Deserialize UserInputMessage SERVER
-void server::deserializeUserInputMessage(const std::vector<uint8_t> &buffer, UserInputMessage &msg)
+void server::deserializeUserInputMessage(std::span<const uint8_t> buffer, UserInputMessage &msg)
 {
-    server::deserializeMessageHeader(buffer, msg.header);
+    const char *error = "Buffer too small for UserInputMessage";
+    size_t offset = sizeof(MessageHeader);
 
-    if (buffer.size() < sizeof(MessageHeader) + sizeof(uint32_t) + sizeof(uint8_t))
-        throw std::runtime_error("Buffer too small for UserInputMessage");
+    server::deserializeMessageHeader(buffer, msg.header);
 
-    memcpy(&msg.clientId, buffer.data() + sizeof(MessageHeader), sizeof(uint32_t));
+    readBytes(buffer, offset, msg.clientId, error);
+    readBytes(buffer, offset, msg.sequence, error);
+    readBytes(buffer, offset, msg.inputFlags, error);
+    readBytes(buffer, offset, msg.previousFlags, error);
     msg.clientId = ntohl(msg.clientId);
-
-    // could use this but since is the last byte we just get the last byte of the buffer
-    // memcpy(&msg.inputFlags,buffer.data() + sizeof(MessageHeader) + sizeof(uint32_t), sizeof(uint8_t));
-    msg.inputFlags = buffer[sizeof(MessageHeader) +
-                            sizeof(uint32_t)];  // input flags is the last byte of teh buffer (only 1 byte for now)
+    msg.sequence = ntohl(msg.sequence);
 }
 
 // Deserialize DisconnectMessage
 
 // ----------------- Deserialize ----------------- //
-void server::deserializeGameOverMessage(const std::vector<uint8_t> &buffer, GameOverMessage &msg)
+void server::deserializeGameOverMessage(std::span<const uint8_t> buffer, GameOverMessage &msg)
 {
     // First deserialize the common message header (4 bytes)
     server::deserializeMessageHeader(buffer, msg.header);
@@ -203,3 +462,149 @@ void server::deserializeGameOverMessage(const std::vector<uint8_t> &buffer, Game
     msg.condition = static_cast<GameOverType>(rawCondition);
     offset += sizeof(uint16_t);
 }
+
+// Deserialize InputAckMessage (CLIENT)
+void server::deserializeInputAckMessage(std::span<const uint8_t> buffer, InputAckMessage &msg)
+{
+    const char *error = "Buffer too small for InputAckMessage";
+    size_t offset = sizeof(MessageHeader);
+    uint32_t posX;
+    uint32_t posY;
+
+    server::deserializeMessageHeader(buffer, msg.header);
+
+    readBytes(buffer, offset, msg.clientId, error);
+    readBytes(buffer, offset, msg.sequence, error);
+    readBytes(buffer, offset, posX, error);
+    readBytes(buffer, offset, posY, error);
+    msg.clientId = ntohl(msg.clientId);
+    msg.sequence = ntohl(msg.sequence);
+    msg.posX = std::bit_cast<float>(ntohl(posX));
+    msg.posY = std::bit_cast<float>(ntohl(posY));
+}
+
+// Deserialize DeltaStateUpdateMessage (CLIENT)
+void server::deserializeDeltaStateUpdateMessage(std::span<const uint8_t> buffer, DeltaStateUpdateMessage &msg)
+{
+    const char *error = "Buffer too small for DeltaStateUpdateMessage";
+    size_t offset = sizeof(MessageHeader);
+    uint16_t numCreated;
+    uint16_t numUpdated;
+    uint16_t numDestroyed;
+
+    server::deserializeMessageHeader(buffer, msg.header);
+
+    readBytes(buffer, offset, msg.sequence, error);
+    readBytes(buffer, offset, msg.baseSequence, error);
+    readBytes(buffer, offset, numCreated, error);
+    readBytes(buffer, offset, numUpdated, error);
+    readBytes(buffer, offset, numDestroyed, error);
+    msg.sequence = ntohl(msg.sequence);
+    msg.baseSequence = ntohl(msg.baseSequence);
+
+    // Ids are sent as gaps from the previous id of the list
+    BitReader reader(buffer, offset);
+    uint32_t entityId = 0;
+    msg.created.resize(ntohs(numCreated));
+    for (auto &entity : msg.created)
+    {
+        entityId += reader.readVarint();
+        entity.entityId = entityId;
+        readCreatedEntity(reader, entity);
+    }
+
+    entityId = 0;
+    msg.updated.resize(ntohs(numUpdated));
+    for (auto &delta : msg.updated)
+    {
+        entityId += reader.readVarint();
+        delta.state = {};
+        delta.state.entityId = entityId;
+        readUpdatedEntity(reader, delta);
+    }
+
+    entityId = 0;
+    msg.destroyed.resize(ntohs(numDestroyed));
+    for (auto &destroyedId : msg.destroyed)
+    {
+        entityId += reader.readVarint();
+        destroyedId = entityId;
+    }
+}
+
+// Deserialize SnapshotAckMessage SERVER
+void server::deserializeSnapshotAckMessage(std::span<const uint8_t> buffer, SnapshotAckMessage &msg)
+{
+    const char *error = "Buffer too small for SnapshotAckMessage";
+    size_t offset = sizeof(MessageHeader);
+
+    server::deserializeMessageHeader(buffer, msg.header);
+
+    readBytes(buffer, offset, msg.clientId, error);
+    readBytes(buffer, offset, msg.sequence, error);
+    msg.clientId = ntohl(msg.clientId);
+    msg.sequence = ntohl(msg.sequence);
+}
+
+// Deserialize FragmentMessage (CLIENT), the payload is left in the buffer
+void server::deserializeFragmentMessage(std::span<const uint8_t> buffer, FragmentView &view)
+{
+    const char *error = "Buffer too small for FragmentMessage";
+    size_t offset = sizeof(MessageHeader);
+
+    server::deserializeMessageHeader(buffer, view.header);
+
+    readBytes(buffer, offset, view.groupId, error);
+    readBytes(buffer, offset, view.fragmentIndex, error);
+    readBytes(buffer, offset, view.fragmentCount, error);
+    view.groupId = ntohl(view.groupId);
+    if (view.fragmentIndex >= view.fragmentCount)
+        throw std::runtime_error("Invalid fragment index in FragmentMessage");
+
+    view.payload = buffer.subspan(offset);
+}
+
+void server::deserializeFragmentMessage(std::span<const uint8_t> buffer, FragmentMessage &msg)
+{
+    FragmentView view;
+
+    server::deserializeFragmentMessage(buffer, view);
+    msg.header = view.header;
+    msg.groupId = view.groupId;
+    msg.fragmentIndex = view.fragmentIndex;
+    msg.fragmentCount = view.fragmentCount;
+    msg.payload.assign(view.payload.begin(), view.payload.end());
+}
+
+// Deserialize ReliableMessage, the payload is left in the buffer
+void server::deserializeReliableMessage(std::span<const uint8_t> buffer, ReliableView &view)
+{
+    const char *error = "Buffer too small for ReliableMessage";
+    size_t offset = sizeof(MessageHeader);
+
+    server::deserializeMessageHeader(buffer, view.header);
+
+    readBytes(buffer, offset, view.clientId, error);
+    readBytes(buffer, offset, view.sequence, error);
+    readBytes(buffer, offset, view.ack, error);
+    readBytes(buffer, offset, view.ackBits, error);
+    view.clientId = ntohl(view.clientId);
+    view.sequence = ntohl(view.sequence);
+    view.ack = ntohl(view.ack);
+    view.ackBits = ntohl(view.ackBits);
+
+    view.payload = buffer.subspan(offset);
+}
+
+void server::deserializeReliableMessage(std::span<const uint8_t> buffer, ReliableMessage &msg)
+{
+    ReliableView view;
+
+    server::deserializeReliableMessage(buffer, view);
+    msg.header = view.header;
+    msg.clientId = view.clientId;
+    msg.sequence = view.sequence;
+    msg.ack = view.ack;
+    msg.ackBits = view.ackBits;
+    msg.payload.assign(view.payload.begin(), view.payload.end());
+}
@@ -0,0 +1,63 @@
+#include "ReliableChannel.hpp"
+
+using namespace server;
+
+ReliableChannel::ReliableChannel() : _pending(), _early() {}
+
+ReliableChannel::~ReliableChannel() {}
+
+uint32_t ReliableChannel::push(std::span<const uint8_t> message)
+{
+    Pending &pending = _pending.emplace_back();
+
+    pending.sequence = _nextSequence++;
+    pending.message.assign(message.begin(), message.end());
+    return pending.sequence;
+}
+
+void ReliableChannel::acknowledge(uint32_t ack, uint32_t ackBits)
+{
+    if (ack == 0)
+        return;
+
+    std::erase_if(_pending, [ack, ackBits](const Pending &pending) {
+        uint32_t before = ack - pending.sequence;  // How far before ack, wraps around when after it
+        return before == 0 || (before <= 32 && (ackBits >> (before - 1)) & 1);
+    });
+}
+
+bool ReliableChannel::idle() const
+{
+    return _pending.empty();
+}
+
+bool ReliableChannel::expired(Clock::time_point now) const
+{
+    // The oldest message was the first one sent
+    return !_pending.empty() && _pending.front().sentAt != Clock::time_point() &&
+           now - _pending.front().firstSentAt >= std::chrono::milliseconds(RELIABLE_TIMEOUT_MS);
+}
+
+uint32_t ReliableChannel::lastReceived() const
+{
+    return _lastReceived;
+}
+
+uint32_t ReliableChannel::ackBits(uint32_t ack) const
+{
+    uint32_t bits = 0;
+
+    for (uint32_t i = 0; i < 32 && i + 1 < ack; ++i)
+    {
+        if (received(ack - 1 - i))
+            bits |= 1u << i;
+    }
+    return bits;
+}
+
+bool ReliableChannel::received(uint32_t sequence) const
+{
+    if (sequence < _nextDelivery)
+        return true;
+    return sequence < _nextDelivery + RELIABLE_WINDOW && _early[sequence % RELIABLE_WINDOW].received;
+}
@@ -0,0 +1,50 @@
+#include "SendBufferPool.hpp"
+
+using namespace server;
+
+SendBufferPool::SendBufferPool(size_t preallocated)
+{
+    _buffers.reserve(preallocated);
+    _free.reserve(preallocated);
+    for (size_t i = 0; i < preallocated; ++i)
+    {
+        _buffers.push_back(std::make_unique<Buffer>());
+        _free.push_back(_buffers.back().get());
+    }
+}
+
+SendBufferPool::~SendBufferPool() {}
+
+SendBufferPool::Buffer *SendBufferPool::acquire()
+{
+    Buffer *buffer = nullptr;
+
+    if (_free.empty())
+    {
+        _buffers.push_back(std::make_unique<Buffer>());
+        buffer = _buffers.back().get();
+    } else
+    {
+        buffer = _free.back();
+        _free.pop_back();
+    }
+    buffer->size = 0;
+    buffer->references = 1;
+    return buffer;
+}
+
+void SendBufferPool::retain(Buffer *buffer)
+{
+    ++buffer->references;
+}
+
+void SendBufferPool::release(Buffer *buffer)
+{
+    if (--buffer->references == 0)
+        _free.push_back(buffer);
+}
+
+size_t SendBufferPool::allocated() const
+{
+    return _buffers.size();
+}
@@ -0,0 +1,241 @@
+#include "SnapshotHistory.hpp"
+
+#include "BitStream.hpp"
+
+#include <algorithm>
+
+using namespace server;
+
+SnapshotHistory::SnapshotHistory() : _snapshots(), _latestSequence(0) {}
+
+SnapshotHistory::~SnapshotHistory() {}
+
+// Orders entity states by id, the order of every snapshot and delta list
+static bool byEntityId(const EntityState &lhs, const EntityState &rhs)
+{
+    return lhs.entityId < rhs.entityId;
+}
+
+uint32_t SnapshotHistory::push(const std::vector<EntityState> &entities)
+{
+    store(++_latestSequence, entities);
+
+    // Kept as the client will see them, so a change the wire can't carry doesn't end up in a delta
+    Snapshot &snapshot = _snapshots[_latestSequence % SNAPSHOT_HISTORY_SIZE];
+    for (EntityState &state : snapshot.entities)
+    {
+        quantizeEntityState(state);
+    }
+    return _latestSequence;
+}
+
+void SnapshotHistory::store(uint32_t sequence, const std::vector<EntityState> &entities)
+{
+    Snapshot &snapshot = _snapshots[sequence % SNAPSHOT_HISTORY_SIZE];
+
+    snapshot.sequence = sequence;
+    snapshot.entities.assign(entities.begin(), entities.end());
+    std::sort(snapshot.entities.begin(), snapshot.entities.end(), byEntityId);
+}
+
+const std::vector<EntityState> *SnapshotHistory::find(uint32_t sequence) const
+{
+    const Snapshot &snapshot = _snapshots[sequence % SNAPSHOT_HISTORY_SIZE];
+
+    if (sequence == 0 || snapshot.sequence != sequence)
+        return nullptr;
+    return &snapshot.entities;
+}
+
+uint32_t SnapshotHistory::latestSequence() const
+{
+    return _latestSequence;
+}
+
+// Mask of the fields that differ between two states of the same entity
+static uint8_t changedFields(const EntityState &base, const EntityState &current)
+{
+    uint8_t mask = 0;
+
+    if (base.clientId != current.clientId)
+        mask |= static_cast<uint8_t>(EntityField::ClientId);
+    if (base.posX != current.posX)
+        mask |= static_cast<uint8_t>(EntityField::PosX);
+    if (base.posY != current.posY)
+        mask |= static_cast<uint8_t>(EntityField::PosY);
+    if (base.velX != current.velX)
+        mask |= static_cast<uint8_t>(EntityField::VelX);
+    if (base.velY != current.velY)
+        mask |= static_cast<uint8_t>(EntityField::VelY);
+    if (base.entityType != current.entityType)
+        mask |= static_cast<uint8_t>(EntityField::EntityType);
+    if (base.health != current.health)
+        mask |= static_cast<uint8_t>(EntityField::Health);
+    return mask;
+}
+
+void server::diffSnapshots(const std::vector<EntityState> &base, const std::vector<EntityState> &current,
+                           DeltaStateUpdateMessage &delta)
+{
+    auto baseIt = base.begin();
+    auto currentIt = current.begin();
+
+    delta.created.clear();
+    delta.updated.clear();
+    delta.destroyed.clear();
+
+    // Both lists are sorted by entity id, walk them side by side
+    while (baseIt != base.end() || currentIt != current.end())
+    {
+        if (currentIt == current.end() || (baseIt != base.end() && baseIt->entityId < currentIt->entityId))
+        {
+            delta.destroyed.push_back(baseIt->entityId);
+            ++baseIt;
+        } else if (baseIt == base.end() || currentIt->entityId < baseIt->entityId)
+        {
+            delta.created.push_back(*currentIt);
+            ++currentIt;
+        } else
+        {
+            uint8_t mask = changedFields(*baseIt, *currentIt);
+
+            if (mask != 0)
+                delta.updated.push_back({mask, *currentIt});
+            ++baseIt;
+            ++currentIt;
+        }
+    }
+}
+
+// Copies the fields set in the delta mask into the entity state
+static void patchEntity(EntityState &state, const EntityDelta &delta)
+{
+    auto has = [&delta](EntityField field) { return (delta.fieldMask & static_cast<uint8_t>(field)) != 0; };
+
+    if (has(EntityField::ClientId))
+        state.clientId = delta.state.clientId;
+    if (has(EntityField::PosX))
+        state.posX = delta.state.posX;
+    if (has(EntityField::PosY))
+        state.posY = delta.state.posY;
+    if (has(EntityField::VelX))
+        state.velX = delta.state.velX;
+    if (has(EntityField::VelY))
+        state.velY = delta.state.velY;
+    if (has(EntityField::EntityType))
+        state.entityType = delta.state.entityType;
+    if (has(EntityField::Health))
+        state.health = delta.state.health;
+}
+
+void server::applyDelta(const std::vector<EntityState> &base, const DeltaStateUpdateMessage &delta,
+                        std::vector<EntityState> &result)
+{
+    auto updated = delta.updated.begin();
+
+    result.clear();
+    for (const EntityState &entity : base)
+    {
+        if (std::binary_search(delta.destroyed.begin(), delta.destroyed.end(), entity.entityId))
+            continue;
+
+        result.push_back(entity);
+        // Both lists are sorted by id, the next update can only be for this entity or a later one
+        while (updated != delta.updated.end() && updated->state.entityId < entity.entityId)
+            ++updated;
+        if (updated != delta.updated.end() && updated->state.entityId == entity.entityId)
+            patchEntity(result.back(), *updated);
+    }
+    result.insert(result.end(), delta.created.begin(), delta.created.end());
+    std::sort(result.begin(), result.end(), byEntityId);
+}
+
+// Lower is sent first: players, then the other entities by distance to the client's player
+static float sendPriority(const EntityState &state, const EntityState *player)
+{
+    if (state.entityType == EntityType::PLAYER)
+        return -1.0f;
+    if (player == nullptr)
+        return 0.0f;
+
+    float dx = state.posX - player->posX;
+    float dy = state.posY - player->posY;
+    return dx * dx + dy * dy;
+}
+
+void server::packDelta(const DeltaStateUpdateMessage &delta, const std::vector<EntityState> &current,
+                       uint32_t clientId, size_t budget, DeltaStateUpdateMessage &packed)
+{
+    struct Candidate
+    {
+        float priority;
+        size_t index;  // in delta.created if created, in delta.updated otherwise
+        bool created;
+    };
+
+    const EntityState *player = nullptr;
+    for (const EntityState &entity : current)
+    {
+        if (entity.entityType == EntityType::PLAYER && entity.clientId == clientId)
+            player = &entity;
+    }
+
+    // Updated entries may not carry the position, take it from the current snapshot
+    auto currentState = [&current](const EntityState &state) -> const EntityState & {
+        auto it = std::lower_bound(current.begin(), current.end(), state, byEntityId);
+        return (it != current.end() && it->entityId == state.entityId) ? *it : state;
+    };
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(delta.created.size() + delta.updated.size());
+    for (size_t i = 0; i < delta.created.size(); ++i)
+    {
+        candidates.push_back({sendPriority(delta.created[i], player), i, true});
+    }
+    for (size_t i = 0; i < delta.updated.size(); ++i)
+    {
+        candidates.push_back({sendPriority(currentState(delta.updated[i].state), player), i, false});
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate &lhs, const Candidate &rhs) { return lhs.priority < rhs.priority; });
+
+    packed.header = delta.header;
+    packed.sequence = delta.sequence;
+    packed.baseSequence = delta.baseSequence;
+    packed.created.clear();
+    packed.updated.clear();
+    packed.destroyed.clear();
+
+    // Sizes are counted in bits, every id as if it was sent whole: the real size can only be smaller
+    size_t budgetBits = budget * 8;
+    size_t bits = DELTA_STATE_UPDATE_HEADER_SIZE * 8;
+
+    // Destroyed entities first: a few bits each, and a ghost left on screen is the most visible error
+    for (uint32_t entityId : delta.destroyed)
+    {
+        if (bits + varintBits(entityId) > budgetBits)
+            break;
+        packed.destroyed.push_back(entityId);
+        bits += varintBits(entityId);
+    }
+
+    // Skip what doesn't fit, a smaller entry further down may still fit
+    for (const Candidate &candidate : candidates)
+    {
+        size_t entryBits = candidate.created ? createdEntityBits(delta.created[candidate.index])
+                                             : updatedEntityBits(delta.updated[candidate.index]);
+
+        if (bits + entryBits > budgetBits)
+            continue;
+        if (candidate.created)
+            packed.created.push_back(delta.created[candidate.index]);
+        else
+            packed.updated.push_back(delta.updated[candidate.index]);
+        bits += entryBits;
+    }
+
+    // The client walks the lists in id order
+    std::sort(packed.created.begin(), packed.created.end(), byEntityId);
+    std::sort(packed.updated.begin(), packed.updated.end(),
+              [](const EntityDelta &lhs, const EntityDelta &rhs) { return lhs.state.entityId < rhs.state.entityId; });
+}
@@ -0,0 +1,40 @@
+#include "SpanWriter.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace server;
+
+SpanWriter::SpanWriter(std::span<uint8_t> buffer) : _buffer(buffer), _size(0) {}
+
+SpanWriter::~SpanWriter() {}
+
+void SpanWriter::writeByte(uint8_t value)
+{
+    if (_size >= _buffer.size())
+        throw std::runtime_error("Span writer write past the end of the buffer");
+    _buffer[_size++] = value;
+}
+
+void SpanWriter::writeBytes(const void *data, size_t size)
+{
+    if (size > _buffer.size() - _size)
+        throw std::runtime_error("Span writer write past the end of the buffer");
+    memcpy(_buffer.data() + _size, data, size);
+    _size += size;
+}
+
+uint8_t *SpanWriter::data()
+{
+    return _buffer.data();
+}
+
+size_t SpanWriter::size() const
+{
+    return _size;
+}
+
+size_t SpanWriter::capacity() const
+{
+    return _buffer.size();
+}